@@ -40,6 +40,12 @@ class NewtonSim {
     void *Top(uint32_t channel) const;
     void Pop(uint32_t channel);
 
+    // checkpoint of the whole memory system (bank/refresh state, stats, clocks).
+    // it can be taken only when no transaction is in flight (IsIdle).
+    bool IsIdle() const;
+    void SaveState(const std::string &path) const;
+    void LoadState(const std::string &path);
+
   private:
     // These have to be pointers because Gem5 will try to push this object
     // into container which will invoke a copy constructor, using pointers
@@ -50,6 +56,7 @@ class NewtonSim {
         bool isAvailable() const;
         bool isAvailable(uint32_t count) const;
         bool isEmpty() const;
+        bool isIdle() const { return OutputQueue.empty() && NumReserved == 0; }
         void reserve();
         void push(void *original_req);
         void *top() const;
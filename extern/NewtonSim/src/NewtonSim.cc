@@ -137,6 +137,44 @@ bool NewtonSim::IsEmpty(uint32_t channel) const {
     //           << ") : " << std::to_string(empty) << std::endl;
     return empty;
 };
+bool NewtonSim::IsIdle() const {
+    if (!pending_read_q_.empty() || !pending_write_q_.empty())
+        return false;
+    for (const auto &queue : response_queues_) {
+        if (!queue.isIdle())
+            return false;
+    }
+    return dram_system_->IsIdle();
+}
+
+void NewtonSim::SaveState(const std::string &path) const {
+    if (!IsIdle()) {
+        PrintError("NewtonSim checkpoint with transactions in flight");
+    }
+    nlohmann::json j;
+    j["income_req_cnt"] = income_req_cnt_;
+    j["outcome_req_cnt"] = outcome_req_cnt_;
+    dram_system_->SaveState(j["dram_system"]);
+
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        PrintError("Can't write checkpoint file -", path);
+    }
+    out << j;
+}
+
+void NewtonSim::LoadState(const std::string &path) {
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        PrintError("Can't load checkpoint file -", path);
+    }
+    nlohmann::json j;
+    in >> j;
+    income_req_cnt_ = j["income_req_cnt"];
+    outcome_req_cnt_ = j["outcome_req_cnt"];
+    dram_system_->LoadState(j["dram_system"]);
+}
+
 void *NewtonSim::Top(uint32_t channel) const {
     // printf("TOP channel= %d\n", channel);
     return response_queues_[channel].top();
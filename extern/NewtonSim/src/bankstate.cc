@@ -579,4 +579,26 @@ void BankState::UpdateStateSingle(const Command &cmd) {
     return;
 }
 
+void BankState::SaveState(nlohmann::json &j) const {
+    j["state"] = static_cast<int>(state_);
+    j["pim_state"] = static_cast<int>(pim_state_);
+    j["pim_lock"] = pim_lock_;
+    j["cmd_timing"] = cmd_timing_;
+    j["open_row"] = open_row_;
+    j["pim_open_row"] = pim_open_row_;
+    j["row_hit_count"] = row_hit_count_;
+    j["pim_enter_count"] = pim_enter_count_;
+}
+
+void BankState::LoadState(const nlohmann::json &j) {
+    state_ = static_cast<State>(j["state"].get<int>());
+    pim_state_ = static_cast<State>(j["pim_state"].get<int>());
+    pim_lock_ = j["pim_lock"];
+    cmd_timing_ = j["cmd_timing"].get<std::vector<uint64_t>>();
+    open_row_ = j["open_row"];
+    pim_open_row_ = j["pim_open_row"];
+    row_hit_count_ = j["row_hit_count"];
+    pim_enter_count_ = j["pim_enter_count"];
+}
+
 }  // namespace dramsim3
@@ -42,6 +42,10 @@ class BankState {
     int OpenRow() const { return open_row_; }
     int PIMOpenRow() const { return enable_dual_buffer_ ? pim_open_row_ : open_row_; }
     int RowHitCount() const { return row_hit_count_; }
+
+    // checkpoint
+    void SaveState(nlohmann::json &j) const;
+    void LoadState(const nlohmann::json &j);
     std::string StateToString() const {
         switch (state_) {
             case State::OPEN:
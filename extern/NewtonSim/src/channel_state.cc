@@ -666,4 +666,51 @@ bool ChannelState::Is32AWReady(int rank, uint64_t curr_time) const {
     return true;
 }
 
+void ChannelState::SaveState(nlohmann::json &j) const {
+    j["rank_idle_cycles"] = rank_idle_cycles;
+    j["pim_open_row"] = pim_open_row_;
+    j["comp_overhead_flag"] = comp_overhead_flag_;
+    j["rank_is_sref"] = rank_is_sref_;
+    j["four_aw"] = four_aw_;
+    j["thirty_two_aw"] = thirty_two_aw_;
+    nlohmann::json refresh_q = nlohmann::json::array();
+    for (const auto &cmd : refresh_q_) {
+        refresh_q.push_back(CommandToJson(cmd));
+    }
+    j["refresh_q"] = refresh_q;
+    nlohmann::json banks = nlohmann::json::array();
+    for (const auto &rank_states : bank_states_) {
+        for (const auto &bg_states : rank_states) {
+            for (const auto &bank_state : bg_states) {
+                nlohmann::json bank;
+                bank_state.SaveState(bank);
+                banks.push_back(bank);
+            }
+        }
+    }
+    j["bank_states"] = banks;
+}
+
+void ChannelState::LoadState(const nlohmann::json &j) {
+    rank_idle_cycles = j["rank_idle_cycles"].get<std::vector<int>>();
+    pim_open_row_ = j["pim_open_row"];
+    comp_overhead_flag_ = j["comp_overhead_flag"];
+    rank_is_sref_ = j["rank_is_sref"].get<std::vector<bool>>();
+    four_aw_ = j["four_aw"].get<std::vector<std::vector<uint64_t>>>();
+    thirty_two_aw_ = j["thirty_two_aw"].get<std::vector<std::vector<uint64_t>>>();
+    refresh_q_.clear();
+    for (const auto &cmd : j["refresh_q"]) {
+        refresh_q_.push_back(CommandFromJson(cmd));
+    }
+    const auto &banks = j["bank_states"];
+    size_t idx = 0;
+    for (auto &rank_states : bank_states_) {
+        for (auto &bg_states : rank_states) {
+            for (auto &bank_state : bg_states) {
+                bank_state.LoadState(banks.at(idx++));
+            }
+        }
+    }
+}
+
 }  // namespace dramsim3
@@ -44,6 +44,10 @@ class ChannelState {
 
     int EstimatePIMOperationLatency(const Command &cmd, uint64_t clk);
 
+    // checkpoint
+    void SaveState(nlohmann::json &j) const;
+    void LoadState(const nlohmann::json &j);
+
     std::vector<int> rank_idle_cycles;
     int pim_open_row_ = -1;
 
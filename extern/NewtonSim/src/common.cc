@@ -187,4 +187,41 @@ void PrintTransactionLog(std::string method_name, int channel_id, int clk,
     //    std::hex, std::uppercase, cmd.hex_addr, std::dec
 }
 
-}  // namespace dramsim3
\ No newline at end of file
+nlohmann::json CommandToJson(const Command &cmd) {
+    const Address &addr = cmd.addr;
+    return nlohmann::json{static_cast<int>(cmd.cmd_type),
+                          addr.channel,
+                          addr.rank,
+                          addr.bankgroup,
+                          addr.bank,
+                          addr.row,
+                          addr.column,
+                          cmd.hex_addr,
+                          cmd.for_gwrite,
+                          cmd.num_comps,
+                          cmd.num_readres,
+                          cmd.is_last_comps};
+}
+
+Command CommandFromJson(const nlohmann::json &j) {
+    Address addr(j[1].get<int>(), j[2].get<int>(), j[3].get<int>(), j[4].get<int>(),
+                 j[5].get<int>(), j[6].get<int>());
+    Command cmd(static_cast<CommandType>(j[0].get<int>()), addr, j[7].get<uint64_t>(),
+                j[8].get<bool>(), j[9].get<int>(), j[10].get<int>());
+    cmd.is_last_comps = j[11].get<bool>();
+    return cmd;
+}
+
+nlohmann::json TransactionToJson(const Transaction &trans) {
+    return nlohmann::json{trans.addr, trans.added_cycle, trans.complete_cycle,
+                          static_cast<int>(trans.req_type)};
+}
+
+Transaction TransactionFromJson(const nlohmann::json &j) {
+    Transaction trans(j[0].get<uint64_t>(), static_cast<TransactionType>(j[3].get<int>()));
+    trans.added_cycle = j[1].get<uint64_t>();
+    trans.complete_cycle = j[2].get<uint64_t>();
+    return trans;
+}
+
+}  // namespace dramsim3
@@ -8,6 +8,8 @@
 #include <string>
 #include <vector>
 
+#include "json.hpp"
+
 namespace dramsim3 {
 
 struct Address {
@@ -385,5 +387,11 @@ std::string HexString(uint64_t addr);
 void PrintControllerLog(std::string method_name, int channel_id, int clk, const Command &cmd);
 void PrintTransactionLog(std::string method_name, int channel_id, int clk,
                          const Transaction &trans);
+
+// checkpoint (NewtonSim::SaveState / LoadState) helpers
+nlohmann::json CommandToJson(const Command &cmd);
+nlohmann::json TransactionToJson(const Transaction &trans);
+Transaction TransactionFromJson(const nlohmann::json &j);
+Command CommandFromJson(const nlohmann::json &j);
 } // namespace dramsim3
 #endif
@@ -199,6 +199,12 @@ void Config::InitOtherParams() {
     // 1: default value, adds epoch CSV output on level 0
     // 2: adds histogram outputs in a different CSV format
     output_level = reader.GetInteger("other", "output_level", 1);
+    // number of threads ticking channel controllers (1: serial)
+    tick_threads = GetInteger("other", "tick_threads", 1);
+    if (tick_threads < 1) {
+        std::cerr << "tick_threads must be at least 1" << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
     // Other Parameters
     // give a prefix instead of specify the output name one by one...
     // this would allow outputing to a directory and you can always override
@@ -151,6 +151,7 @@ class Config {
 
     int epoch_period;
     int output_level;
+    int tick_threads;
     std::string output_dir;
     std::string output_prefix;
     std::string json_stats_name;
@@ -29,6 +29,14 @@ class Controller {
     virtual std::pair<uint64_t, TransactionType> ReturnDoneTrans(uint64_t clock) = 0;
     virtual void ResetPIMCycle() = 0;
     virtual uint64_t GetPIMCycle() = 0;
+    // checkpoint: only supported at a quiescent point (no transaction in flight)
+    virtual bool IsIdle() const { return false; }
+    virtual void SaveState(nlohmann::json &j) const {
+        PrintError("Checkpoint is not supported for this memory type");
+    }
+    virtual void LoadState(const nlohmann::json &j) {
+        PrintError("Checkpoint is not supported for this memory type");
+    }
 };
 } // namespace dramsim3
 #endif
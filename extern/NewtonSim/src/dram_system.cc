@@ -2,6 +2,8 @@
 
 #include <assert.h>
 
+#include <algorithm>
+
 namespace dramsim3 {
 
 // alternative way is to assign the id in constructor but this is less
@@ -70,6 +72,44 @@ void BaseDRAMSystem::ResetStats() {
     }
 }
 
+bool BaseDRAMSystem::IsIdle() const {
+    for (auto ctrl : ctrls_) {
+        if (!ctrl->IsIdle())
+            return false;
+    }
+    return true;
+}
+
+void BaseDRAMSystem::SaveState(nlohmann::json &j) const {
+    j["clk"] = clk_;
+    j["last_req_clk"] = last_req_clk_;
+    nlohmann::json ctrls = nlohmann::json::array();
+    for (size_t i = 0; i < ctrls_.size(); i++) {
+        nlohmann::json ctrl;
+        ctrls_[i]->SaveState(ctrl);
+        ctrls.push_back(ctrl);
+    }
+    j["ctrls"] = ctrls;
+}
+
+void BaseDRAMSystem::LoadState(const nlohmann::json &j) {
+    clk_ = j["clk"];
+    last_req_clk_ = j["last_req_clk"];
+    const auto &ctrls = j["ctrls"];
+    if (ctrls.size() != ctrls_.size()) {
+        PrintError("Checkpoint has", ctrls.size(), "channels, but config has", ctrls_.size());
+    }
+    for (size_t i = 0; i < ctrls_.size(); i++) {
+        ctrls_[i]->LoadState(ctrls[i]);
+    }
+    // earlier epochs were written by the run that saved the checkpoint,
+    // start a new epoch file so that PrintStats() can close it
+    if (clk_ >= static_cast<uint64_t>(config_.epoch_period)) {
+        std::ofstream epoch_out(config_.json_epoch_name, std::ofstream::out);
+        epoch_out << "[";
+    }
+}
+
 void BaseDRAMSystem::RegisterCallbacks(std::function<void(uint64_t)> read_callback,
                                        std::function<void(uint64_t)> write_callback) {
     // this should be propagated to controllers
@@ -80,7 +120,7 @@ void BaseDRAMSystem::RegisterCallbacks(std::function<void(uint64_t)> read_callba
 JedecDRAMSystem::JedecDRAMSystem(Config &config, const std::string &output_dir,
                                  std::function<void(uint64_t)> read_callback,
                                  std::function<void(uint64_t)> write_callback)
-    : BaseDRAMSystem(config, output_dir, read_callback, write_callback) {
+    : BaseDRAMSystem(config, output_dir, read_callback, write_callback), tick_pool_(nullptr) {
     ctrls_.reserve(config_.channels);
     for (auto i = 0; i < config_.channels; i++) {
         Controller *ctrl;
@@ -96,6 +136,16 @@ JedecDRAMSystem::JedecDRAMSystem(Config &config, const std::string &output_dir,
 
         ctrls_.push_back(ctrl);
     }
+
+    int tick_threads = std::min(config_.tick_threads, config_.channels);
+    if (tick_threads > 1) {
+        tick_task_ = [this, tick_threads](int worker_id) {
+            for (size_t i = worker_id; i < ctrls_.size(); i += tick_threads) {
+                ctrls_[i]->ClockTick();
+            }
+        };
+        tick_pool_ = new TickPool(tick_threads);
+    }
 }
 
 uint64_t JedecDRAMSystem::GetAvgPIMCycles() {
@@ -119,6 +169,7 @@ void JedecDRAMSystem::ResetPIMCycle() {
 }
 
 JedecDRAMSystem::~JedecDRAMSystem() {
+    delete tick_pool_;
     for (auto it = ctrls_.begin(); it != ctrls_.end(); it++) {
         delete (*it);
     }
@@ -167,8 +218,12 @@ void JedecDRAMSystem::ClockTick() {
             }
         }
     }
-    for (size_t i = 0; i < ctrls_.size(); i++) {
-        ctrls_[i]->ClockTick();
+    if (tick_pool_) {
+        tick_pool_->Run(tick_task_);
+    } else {
+        for (size_t i = 0; i < ctrls_.size(); i++) {
+            ctrls_[i]->ClockTick();
+        }
     }
     clk_++;
 
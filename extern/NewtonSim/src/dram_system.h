@@ -11,6 +11,7 @@
 #include "dram_controller.h"
 #include "neupims_controller.h"
 #include "newton_controller.h"
+#include "tick_pool.h"
 #include "timing.h"
 
 namespace dramsim3 {
@@ -38,6 +39,11 @@ class BaseDRAMSystem {
     virtual uint64_t GetAvgPIMCycles() = 0;
     virtual void ResetPIMCycle() = 0;
 
+    // checkpoint
+    bool IsIdle() const;
+    void SaveState(nlohmann::json &j) const;
+    void LoadState(const nlohmann::json &j);
+
   protected:
     uint64_t id_;
     uint64_t last_req_clk_;
@@ -65,6 +71,12 @@ class JedecDRAMSystem : public BaseDRAMSystem {
     void ClockTick() override;
     uint64_t GetAvgPIMCycles() override;
     void ResetPIMCycle() override;
+
+  private:
+    // controllers of different channels share no state within a tick, so they
+    // can be ticked in parallel (channel i is ticked by worker i % tick_threads)
+    TickPool *tick_pool_;
+    std::function<void(int)> tick_task_;
 };
 
 // Model a memorysystem with an infinite bandwidth and a fixed latency (possibly
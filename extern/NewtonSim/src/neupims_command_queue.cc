@@ -466,4 +466,63 @@ bool NeuPIMSCommandQueue::HasRWDependency(const CMDIterator &cmd_it, const CMDQu
     return false;
 }
 
+void NeuPIMSCommandQueue::SaveState(nlohmann::json &j) const {
+    nlohmann::json queues = nlohmann::json::array();
+    for (const auto &queue : queues_) {
+        nlohmann::json cmds = nlohmann::json::array();
+        for (const auto &cmd : queue) {
+            cmds.push_back(CommandToJson(cmd));
+        }
+        queues.push_back(cmds);
+    }
+    j["queues"] = queues;
+    nlohmann::json pim_queue = nlohmann::json::array();
+    for (const auto &cmd : pim_queue_) {
+        pim_queue.push_back(CommandToJson(cmd));
+    }
+    j["pim_queue"] = pim_queue;
+    j["rank_q_empty"] = rank_q_empty;
+    j["total_pim_cycles"] = total_pim_cycles_;
+    j["ref_q_indices"] = std::vector<int>(ref_q_indices_.begin(), ref_q_indices_.end());
+    j["is_in_ref"] = is_in_ref_;
+    j["is_pim_mode"] = is_pim_mode_;
+    j["skip_pim"] = skip_pim_;
+    j["queue_idx"] = queue_idx_;
+    j["clk"] = clk_;
+    j["remain_slack"] = remain_slack_;
+    j["reserved_row_for_pim"] = reserved_row_for_pim_;
+    j["is_gwriting"] = is_gwriting_;
+    j["gwrite_target"] = {gwrite_target_.channel, gwrite_target_.rank, gwrite_target_.bankgroup,
+                          gwrite_target_.bank,    gwrite_target_.row,  gwrite_target_.column};
+}
+
+void NeuPIMSCommandQueue::LoadState(const nlohmann::json &j) {
+    const auto &queues = j["queues"];
+    for (size_t i = 0; i < queues_.size(); i++) {
+        queues_[i].clear();
+        for (const auto &cmd : queues.at(i)) {
+            queues_[i].push_back(CommandFromJson(cmd));
+        }
+    }
+    pim_queue_.clear();
+    for (const auto &cmd : j["pim_queue"]) {
+        pim_queue_.push_back(CommandFromJson(cmd));
+    }
+    rank_q_empty = j["rank_q_empty"].get<std::vector<bool>>();
+    total_pim_cycles_ = j["total_pim_cycles"];
+    auto ref_q_indices = j["ref_q_indices"].get<std::vector<int>>();
+    ref_q_indices_ = std::unordered_set<int>(ref_q_indices.begin(), ref_q_indices.end());
+    is_in_ref_ = j["is_in_ref"];
+    is_pim_mode_ = j["is_pim_mode"];
+    skip_pim_ = j["skip_pim"];
+    queue_idx_ = j["queue_idx"];
+    clk_ = j["clk"];
+    remain_slack_ = j["remain_slack"];
+    reserved_row_for_pim_ = j["reserved_row_for_pim"];
+    is_gwriting_ = j["is_gwriting"];
+    const auto &target = j["gwrite_target"];
+    gwrite_target_ = Address(target[0].get<int>(), target[1].get<int>(), target[2].get<int>(),
+                             target[3].get<int>(), target[4].get<int>(), target[5].get<int>());
+}
+
 } // namespace dramsim3
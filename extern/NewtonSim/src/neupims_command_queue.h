@@ -35,6 +35,10 @@ class NeuPIMSCommandQueue {
     void ResetPIMCycle() { total_pim_cycles_ = 0; }
     uint64_t GetPIMCycle() { return total_pim_cycles_; }
 
+    // checkpoint
+    void SaveState(nlohmann::json &j) const;
+    void LoadState(const nlohmann::json &j);
+
   private:
     bool ArbitratePrecharge(const CMDIterator &cmd_it, const CMDQueue &queue) const;
     bool HasRWDependency(const CMDIterator &cmd_it, const CMDQueue &queue) const;
@@ -626,8 +626,58 @@ void NeuPIMSController::UpdateCommandStats(const Command &cmd) {
         break;
     default:
         PrintError(cmd.CommandTypeString());
-        AbruptExit(__FILE__, __LINE__);
     }
 }
 
+// writes are acknowledged as soon as they are added, so the posted writes still in the
+// write buffer are saved with the rest of the state
+bool NeuPIMSController::IsIdle() const {
+    return read_queue_.empty() && pim_queue_.empty() && pending_rd_q_.empty() &&
+           pending_pim_q_.empty() && return_queue_.empty();
+}
+
+void NeuPIMSController::SaveState(nlohmann::json &j) const {
+    if (!IsIdle()) {
+        PrintError("cid:", channel_id_, "checkpoint with transactions in flight");
+    }
+    j["clk"] = clk_;
+    j["last_trans_clk"] = last_trans_clk_;
+    j["rw_dependency_lock"] = rw_dependency_lock_;
+    j["rw_dependency_addr"] = rw_dependency_addr_;
+    j["write_draining"] = write_draining_;
+    j["write_buffer"] = nlohmann::json::array();
+    for (const auto &trans : write_buffer_) {
+        j["write_buffer"].push_back(TransactionToJson(trans));
+    }
+    j["pending_wr_q"] = nlohmann::json::array();
+    for (const auto &it : pending_wr_q_) {
+        j["pending_wr_q"].push_back(TransactionToJson(it.second));
+    }
+    simple_stats_.SaveState(j["simple_stats"]);
+    channel_state_.SaveState(j["channel_state"]);
+    pim_cmd_queue_.SaveState(j["cmd_queue"]);
+    refresh_.SaveState(j["refresh"]);
+}
+
+void NeuPIMSController::LoadState(const nlohmann::json &j) {
+    clk_ = j["clk"];
+    last_trans_clk_ = j["last_trans_clk"];
+    rw_dependency_lock_ = j["rw_dependency_lock"];
+    rw_dependency_addr_ = j["rw_dependency_addr"];
+    write_draining_ = j["write_draining"];
+    write_buffer_.clear();
+    for (const auto &trans : j["write_buffer"]) {
+        write_buffer_.push_back(TransactionFromJson(trans));
+    }
+    pending_wr_q_.clear();
+    for (const auto &trans : j["pending_wr_q"]) {
+        Transaction pending = TransactionFromJson(trans);
+        pending_wr_q_.insert(std::make_pair(pending.addr, pending));
+    }
+    simple_stats_.LoadState(j["simple_stats"]);
+    channel_state_.LoadState(j["channel_state"]);
+    pim_cmd_queue_.LoadState(j["cmd_queue"]);
+    refresh_.LoadState(j["refresh"]);
+}
+
 } // namespace dramsim3
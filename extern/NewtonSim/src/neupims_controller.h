@@ -34,6 +34,10 @@ class NeuPIMSController : public Controller {
     void ResetPIMCycle() override;
     uint64_t GetPIMCycle() override;
 
+    bool IsIdle() const override;
+    void SaveState(nlohmann::json &j) const override;
+    void LoadState(const nlohmann::json &j) override;
+
   private:
     uint64_t clk_;
     const Config &config_;
@@ -91,4 +91,18 @@ void Refresh::IterateNext() {
     }
 }
 
+void Refresh::SaveState(nlohmann::json &j) const {
+    j["clk"] = clk_;
+    j["next_rank"] = next_rank_;
+    j["next_bg"] = next_bg_;
+    j["next_bank"] = next_bank_;
+}
+
+void Refresh::LoadState(const nlohmann::json &j) {
+    clk_ = j["clk"];
+    next_rank_ = j["next_rank"];
+    next_bg_ = j["next_bg"];
+    next_bank_ = j["next_bank"];
+}
+
 }  // namespace dramsim3
@@ -16,6 +16,10 @@ class Refresh {
     void ClockTick();
     std::pair<int, int> GetRefreshSlack();
 
+    // checkpoint
+    void SaveState(nlohmann::json &j) const;
+    void LoadState(const nlohmann::json &j);
+
    private:
     uint64_t clk_;
     int refresh_interval_;
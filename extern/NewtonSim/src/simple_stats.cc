@@ -535,4 +535,52 @@ void SimpleStats::UpdateFinalStats() {
     return;
 }
 
-}  // namespace dramsim3
\ No newline at end of file
+// json object keys must be strings, so histograms are stored as [value, count] pairs
+static SimpleStats::Json HistoToJson(const std::unordered_map<std::string, std::unordered_map<int, uint64_t>> &histos) {
+    SimpleStats::Json j;
+    for (const auto &it : histos) {
+        j[it.first] = std::vector<std::pair<int, uint64_t>>(it.second.begin(), it.second.end());
+    }
+    return j;
+}
+
+static void HistoFromJson(const SimpleStats::Json &j,
+                          std::unordered_map<std::string, std::unordered_map<int, uint64_t>> &histos) {
+    for (auto &it : histos) {
+        it.second.clear();
+        if (j.count(it.first) == 0)
+            continue;
+        for (const auto &count : j[it.first].get<std::vector<std::pair<int, uint64_t>>>()) {
+            it.second[count.first] = count.second;
+        }
+    }
+}
+
+void SimpleStats::SaveState(Json &j) const {
+    j["counters"] = counters_;
+    j["epoch_counters"] = epoch_counters_;
+    j["vec_counters"] = vec_counters_;
+    j["epoch_vec_counters"] = epoch_vec_counters_;
+    j["histo_counts"] = HistoToJson(histo_counts_);
+    j["epoch_histo_counts"] = HistoToJson(epoch_histo_counts_);
+}
+
+// stats are registered in the constructor, so values are assigned in place to keep the
+// iteration (print) order of the maps
+template <typename T>
+static void CountersFromJson(const SimpleStats::Json &j, std::unordered_map<std::string, T> &counters) {
+    for (auto &it : counters) {
+        it.second = j[it.first].template get<T>();
+    }
+}
+
+void SimpleStats::LoadState(const Json &j) {
+    CountersFromJson(j["counters"], counters_);
+    CountersFromJson(j["epoch_counters"], epoch_counters_);
+    CountersFromJson(j["vec_counters"], vec_counters_);
+    CountersFromJson(j["epoch_vec_counters"], epoch_vec_counters_);
+    HistoFromJson(j["histo_counts"], histo_counts_);
+    HistoFromJson(j["epoch_histo_counts"], epoch_histo_counts_);
+}
+
+}  // namespace dramsim3
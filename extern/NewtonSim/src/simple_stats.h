@@ -13,6 +13,7 @@ namespace dramsim3 {
 
 class SimpleStats {
   public:
+    using Json = nlohmann::json;
     SimpleStats(const Config &config, int channel_id);
     // incrementing counter
     void Increment(const std::string name) { epoch_counters_[name] += 1; }
@@ -42,10 +43,13 @@ class SimpleStats {
     // Reset (usually after one phase of simulation)
     void Reset();
 
+    // checkpoint: counters and histograms (the rest is derived from them)
+    void SaveState(Json &j) const;
+    void LoadState(const Json &j);
+
   private:
     using VecStat = std::unordered_map<std::string, std::vector<uint64_t>>;
     using HistoCount = std::unordered_map<int, uint64_t>;
-    using Json = nlohmann::json;
     void InitStat(std::string name, std::string stat_type, std::string description);
     void InitVecStat(std::string name, std::string stat_type, std::string description,
                      std::string part_name, int vec_len);
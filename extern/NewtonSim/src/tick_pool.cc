@@ -0,0 +1,49 @@
+#include "tick_pool.h"
+
+#include <assert.h>
+
+namespace dramsim3 {
+
+TickPool::TickPool(int num_workers)
+    : num_workers_(num_workers), task_(nullptr), generation_(0), remaining_(0), stop_(false) {
+    assert(num_workers_ > 0);
+    threads_.reserve(num_workers_ - 1);
+    for (int i = 1; i < num_workers_; i++) {
+        threads_.emplace_back(&TickPool::WorkerLoop, this, i);
+    }
+}
+
+TickPool::~TickPool() {
+    stop_.store(true, std::memory_order_release);
+    for (auto &thread : threads_) {
+        thread.join();
+    }
+}
+
+void TickPool::Run(const std::function<void(int)> &task) {
+    task_ = &task;
+    remaining_.store(num_workers_ - 1, std::memory_order_relaxed);
+    // publish the task (and everything the main thread wrote since the last
+    // barrier, e.g. newly added transactions) to the workers
+    generation_.fetch_add(1, std::memory_order_release);
+    task(0);
+    while (remaining_.load(std::memory_order_acquire) != 0) {
+        std::this_thread::yield();
+    }
+}
+
+void TickPool::WorkerLoop(int worker_id) {
+    uint64_t generation = 0;
+    while (true) {
+        while (generation_.load(std::memory_order_acquire) == generation) {
+            if (stop_.load(std::memory_order_acquire))
+                return;
+            std::this_thread::yield();
+        }
+        generation++;
+        (*task_)(worker_id);
+        remaining_.fetch_sub(1, std::memory_order_acq_rel);
+    }
+}
+
+} // namespace dramsim3
@@ -0,0 +1,35 @@
+#ifndef __TICK_POOL_H
+#define __TICK_POOL_H
+
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace dramsim3 {
+
+// Persistent worker pool used to tick channel controllers in parallel.
+// Run() is called once per DRAM cycle, so workers spin (with yield) on a
+// generation counter instead of sleeping on a condition variable.
+// The calling thread takes part as worker 0.
+class TickPool {
+  public:
+    TickPool(int num_workers);
+    ~TickPool();
+    // run task(worker_id) on all workers and return when every worker is done
+    void Run(const std::function<void(int)> &task);
+    int NumWorkers() const { return num_workers_; }
+
+  private:
+    void WorkerLoop(int worker_id);
+
+    int num_workers_;
+    std::vector<std::thread> threads_;
+    const std::function<void(int)> *task_;
+    std::atomic<uint64_t> generation_;
+    std::atomic<int> remaining_;
+    std::atomic<bool> stop_;
+};
+
+} // namespace dramsim3
+#endif // __TICK_POOL_H
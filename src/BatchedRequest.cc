@@ -1,6 +1,7 @@
 #include "BatchedRequest.h"
 
 #include "./tensor/BTensor.h"
+#include "./tensor/PIMTensor.h"
 
 BatchedRequest::BatchedRequest(
     std::vector<std::shared_ptr<InferRequest>> reqs) {
@@ -56,4 +57,54 @@ BatchedRequest::get_cache(uint32_t layer, uint32_t index) {
 // }
 
 // std::vector<std::shared_ptr<BatchedTensor>> get_cache(uint32_t layer,
-// std::string type) {}
\ No newline at end of file
+// std::string type) {}
+
+json request_to_json(Ptr<InferRequest> request) {
+  json j;
+  j["id"] = request->id;
+  j["arrival_cycle"] = request->arrival_cycle;
+  j["completed_cycle"] = request->completed_cycle;
+  j["input_size"] = request->input_size;
+  j["output_size"] = request->output_size;
+  j["is_initiated"] = request->is_initiated;
+  j["generated"] = request->generated;
+  j["channel"] = request->channel;
+  j["token_cycles"] = request->token_cycles;
+  j["K_cache"] = json::array();
+  j["V_cache"] = json::array();
+  for (auto &cache : request->K_cache) {
+    json tensor;
+    std::static_pointer_cast<PIMTensor>(cache)->save_state(tensor);
+    j["K_cache"].push_back(tensor);
+  }
+  for (auto &cache : request->V_cache) {
+    json tensor;
+    std::static_pointer_cast<PIMTensor>(cache)->save_state(tensor);
+    j["V_cache"].push_back(tensor);
+  }
+  return j;
+}
+
+Ptr<InferRequest> request_from_json(const json &j) {
+  auto request = std::make_shared<InferRequest>(
+      InferRequest{.id = j["id"],
+                   .arrival_cycle = j["arrival_cycle"],
+                   .completed_cycle = j["completed_cycle"],
+                   .input_size = j["input_size"],
+                   .output_size = j["output_size"],
+                   .is_initiated = j["is_initiated"],
+                   .generated = j["generated"],
+                   .channel = j["channel"]});
+  request->token_cycles = j["token_cycles"].get<std::vector<cycle_type>>();
+  for (auto &tensor : j["K_cache"]) {
+    auto cache = std::make_shared<PIMTensor>();
+    cache->load_state(tensor);
+    request->K_cache.push_back(cache);
+  }
+  for (auto &tensor : j["V_cache"]) {
+    auto cache = std::make_shared<PIMTensor>();
+    cache->load_state(tensor);
+    request->V_cache.push_back(cache);
+  }
+  return request;
+}
@@ -15,4 +15,8 @@ class BatchedRequest {
     // todo: switch from Tensor to VirtualTensor
     int _batch_size;
     std::vector<std::shared_ptr<InferRequest>> _reqs;
-};
\ No newline at end of file
+};
+
+// checkpoint of an inference request and its K/V cache (PIMTensor) rows
+json request_to_json(Ptr<InferRequest> request);
+Ptr<InferRequest> request_from_json(const json &j);
@@ -1,13 +1,31 @@
 #include "Common.h"
 
-uint32_t generate_id() {
-  static uint32_t id_counter{0};
-  // 静态局部变量 初值为0 作用是给某个对象创建一个独一无二的ID
-  return id_counter++;
+// 静态变量 初值为0 作用是给某个对象创建一个独一无二的ID
+static uint32_t id_counter{0};
+static uint32_t mem_access_id_counter{0};
+// NPU-only address allocation / constant weight address of PIM stages
+static addr_type npu_base_addr{0};
+static addr_type const_addr{0};
+
+uint32_t generate_id() { return id_counter++; }
+uint32_t generate_mem_access_id() { return mem_access_id_counter++; }
+
+void save_global_state(json &j) {
+  j["id_counter"] = id_counter;
+  j["mem_access_id_counter"] = mem_access_id_counter;
+  j["npu_base_addr"] = npu_base_addr;
+  j["const_addr"] = const_addr;
+  j["req_count"] = MemoryAccess::req_count;
+  j["pre_req_count"] = MemoryAccess::pre_req_count;
 }
-uint32_t generate_mem_access_id() {
-  static uint32_t id_counter{0};
-  return id_counter++;
+
+void load_global_state(const json &j) {
+  id_counter = j["id_counter"];
+  mem_access_id_counter = j["mem_access_id_counter"];
+  npu_base_addr = j["npu_base_addr"];
+  const_addr = j["const_addr"];
+  MemoryAccess::req_count = j["req_count"];
+  MemoryAccess::pre_req_count = j["pre_req_count"];
 }
 
 namespace AddressConfig {
@@ -20,6 +38,69 @@ addr_type channel_offset;                // not used
 int MemoryAccess::req_count = 0;
 int MemoryAccess::pre_req_count = 0;
 
+std::vector<void *> MemoryAccessPool::_slabs;
+std::vector<void *> MemoryAccessPool::_free_list;
+size_t MemoryAccessPool::_in_use = 0;
+size_t MemoryAccessPool::_peak = 0;
+
+using MemoryAccessStorage =
+    std::aligned_storage<sizeof(MemoryAccess), alignof(MemoryAccess)>::type;
+
+void *MemoryAccessPool::allocate() {
+  if (_free_list.empty()) {
+    // grow by one slab and thread all of its slots onto the free list
+    auto slab = new MemoryAccessStorage[_slab_objects];
+    _slabs.push_back(slab);
+    _free_list.reserve(_free_list.size() + _slab_objects);
+    for (size_t i = _slab_objects; i > 0; i--)
+      _free_list.push_back(&slab[i - 1]);
+  }
+  void *ptr = _free_list.back();
+  _free_list.pop_back();
+  _in_use++;
+  _peak = std::max(_peak, _in_use);
+  return ptr;
+}
+
+void MemoryAccessPool::release(void *ptr) {
+  if (ptr == nullptr)
+    return;
+  assert(_in_use > 0);
+  _in_use--;
+  _free_list.push_back(ptr);
+}
+
+size_t MemoryAccessPool::capacity() { return _slabs.size() * _slab_objects; }
+
+std::vector<Ptr<Tile>> TileTable::_tiles;
+std::vector<uint32_t> TileTable::_generations;
+std::vector<uint32_t> TileTable::_free_slots;
+
+TileHandle TileTable::add(Ptr<Tile> tile) {
+  uint32_t index;
+  if (_free_slots.empty()) {
+    index = _tiles.size();
+    _tiles.push_back(nullptr);
+    _generations.push_back(0);
+  } else {
+    index = _free_slots.back();
+    _free_slots.pop_back();
+  }
+  _tiles[index] = tile;
+  // generation 0 is reserved for the empty handle
+  if (++_generations[index] == 0)
+    _generations[index] = 1;
+  return TileHandle{.index = index, .generation = _generations[index]};
+}
+
+void TileTable::remove(TileHandle handle) {
+  if (get(handle) == nullptr)
+    return;
+  _tiles[handle.index] = nullptr;
+  _generations[handle.index]++;
+  _free_slots.push_back(handle.index);
+}
+
 // FIXME: Magic Numbers
 uint32_t AddressConfig::mask_channel(addr_type address) {
   const int col_bits = 4;
@@ -50,17 +131,36 @@ addr_type AddressConfig::switch_co_ch(addr_type addr) {
   return addr;
 }
 
+addr_type AddressConfig::unswitch_co_ch(addr_type addr) {
+  const int num_col_bits = 4;
+  const int num_ch_bits = 5;
+  const int num_offset = 6;
+
+  const addr_type ch_mask = ((1 << num_ch_bits) - 1)
+                            << (num_col_bits + num_offset);
+  const addr_type col_mask = ((1 << num_col_bits) - 1) << num_offset;
+
+  const addr_type mask = ch_mask | col_mask;
+
+  addr_type old_col_bits = (addr & col_mask) << num_ch_bits;
+  addr_type old_ch_bits = (addr & ch_mask) >> num_col_bits;
+
+  addr = addr & (~mask);
+  addr = addr | old_col_bits;
+  addr = addr | old_ch_bits;
+
+  return addr;
+}
+
 // used in NPU-only
 // this is creating dram address.
 // align cachline size to 4B
 // ex) allocate 31 bytes => align to 32 bytes
 addr_type AddressConfig::allocate_address(uint32_t size) {
-  static addr_type base_addr{0};
-
-  addr_type result = base_addr;
-  base_addr += size;
-  if (base_addr & (alignment - 1)) {
-    base_addr += alignment - (base_addr & (alignment - 1));
+  addr_type result = npu_base_addr;
+  npu_base_addr += size;
+  if (npu_base_addr & (alignment - 1)) {
+    npu_base_addr += alignment - (npu_base_addr & (alignment - 1));
   }
 
   return result;
@@ -79,20 +179,30 @@ MemoryAccess::from_instruction(Instruction &inst, uint32_t id, uint32_t size,
                                MemoryAccessType req_type, bool request,
                                uint32_t core_id, cycle_type start_cycle,
                                int buffer_id, StagePlatform stage_platform) {
-  static addr_type const_addr = 0;
   const addr_type max_address = Config::global_config.model_n_embd *
                                 Config::global_config.model_n_embd * 5 * 2 /
                                 Config::global_config.n_tp;
 
+  // One request per burst: every src address advances const_addr by 2, and
+  // all steps that stay inside one aligned block map to the same burst
+  // (switch_co_ch only moves bits above the alignment), so whole blocks are
+  // stepped at once instead of walking the per-element list.
   robin_hood::unordered_set<addr_type> aligned_src_addrs;
-  for (auto addr : inst.src_addrs) {
-    pre_req_count++;
-    const_addr += 2;
-    if (const_addr >= max_address) {
-      const_addr = 0;
+  uint64_t remaining = inst.src_addrs.size();
+  while (remaining > 0) {
+    addr_type next = const_addr + 2;
+    if (next >= max_address) {
+      next = 0;
     }
+    addr_type block_end =
+        std::min(AddressConfig::align(next) + AddressConfig::alignment,
+                 max_address);
+    uint64_t steps = std::min(remaining, (block_end - next + 1) / 2);
     aligned_src_addrs.insert(
-        AddressConfig::align(AddressConfig::switch_co_ch(const_addr)));
+        AddressConfig::align(AddressConfig::switch_co_ch(next)));
+    const_addr = next + 2 * (steps - 1);
+    pre_req_count += steps;
+    remaining -= steps;
   }
 
   std::vector<MemoryAccess *> ret;
@@ -157,9 +267,26 @@ SimulationConfig initialize_config(json config) {
     parsed_config.core_type = CoreType::SYSTOLIC_OS;
   else if ((std::string)config["core_type"] == "systolic_ws")
     parsed_config.core_type = CoreType::SYSTOLIC_WS;
+  else if ((std::string)config["core_type"] == "systolic_is")
+    parsed_config.core_type = CoreType::SYSTOLIC_IS;
   else
     throw std::runtime_error(fmt::format("Not implemented core type {} ",
                                          (std::string)config["core_type"]));
+  if (config.contains("dataflow")) {
+    for (auto &[optype, value] : config["dataflow"].items()) {
+      std::string dataflow = value;
+      if (dataflow == "ws")
+        parsed_config.op_dataflow[optype] = Dataflow::WS;
+      else if (dataflow == "os")
+        parsed_config.op_dataflow[optype] = Dataflow::OS;
+      else if (dataflow == "is")
+        parsed_config.op_dataflow[optype] = Dataflow::IS;
+      else {
+        spdlog::error("unknown dataflow of {}: {}", optype, dataflow);
+        exit(-1);
+      }
+    }
+  }
   parsed_config.core_freq = config["core_freq"];
   parsed_config.core_width = config["core_width"];
   parsed_config.core_height = config["core_height"];
@@ -169,6 +296,13 @@ SimulationConfig initialize_config(json config) {
 
   parsed_config.vector_core_count = config["vector_core_count"];
   parsed_config.vector_core_width = config["vector_core_width"];
+  parsed_config.ex_issue_width = 1;
+  if (config.contains("ex_issue_width"))
+    parsed_config.ex_issue_width = config["ex_issue_width"];
+  parsed_config.ex_issue_window = 1;
+  if (config.contains("ex_issue_window"))
+    parsed_config.ex_issue_window = config["ex_issue_window"];
+  ast(parsed_config.ex_issue_width > 0 && parsed_config.ex_issue_window > 0);
   parsed_config.add_latency = config["add_latency"];
   parsed_config.mul_latency = config["mul_latency"];
   parsed_config.exp_latency = config["exp_latency"];
@@ -200,6 +334,12 @@ SimulationConfig initialize_config(json config) {
     parsed_config.icnt_latency = config["icnt_latency"];
   if (config.contains("icnt_config_path"))
     parsed_config.icnt_config_path = config["icnt_config_path"];
+  parsed_config.icnt_bandwidth = 0;
+  if (config.contains("icnt_bandwidth"))
+    parsed_config.icnt_bandwidth = config["icnt_bandwidth"];
+  parsed_config.icnt_buffer_size = 0;
+  if (config.contains("icnt_buffer_size"))
+    parsed_config.icnt_buffer_size = config["icnt_buffer_size"];
 
   parsed_config.precision = config["precision"];
   parsed_config.layout = config["layout"];
@@ -265,6 +405,15 @@ void initialize_model_config(std::string model_config_path) {
   Config::global_config.model_n_embd = model_config["model_n_embd"];
   /* parallelism config */
   Config::global_config.n_tp = model_config["n_tp"];
+  Config::global_config.n_pp = 1;
+  if (model_config.contains("n_pp"))
+    Config::global_config.n_pp = model_config["n_pp"];
+  if (Config::global_config.n_pp == 0 ||
+      Config::global_config.n_pp > Config::global_config.model_n_layer) {
+    spdlog::error("n_pp {} must be in [1, model_n_layer]",
+                  Config::global_config.n_pp);
+    exit(-1);
+  }
 }
 void initialize_system_config(std::string sys_config_path) {
   json sys_config = load_config(sys_config_path);
@@ -276,7 +425,24 @@ void initialize_system_config(std::string sys_config_path) {
   else
     Config::global_config.run_mode = RunMode::NPU_ONLY;
 
-  Config::global_config.ch_load_balancing = sys_config["ch_load_balancing"];
+  Config::global_config.channel_placement = ChannelPlacement::TRACE;
+  if (sys_config.contains("channel_placement")) {
+    std::string placement = sys_config["channel_placement"];
+    if (placement == "trace")
+      Config::global_config.channel_placement = ChannelPlacement::TRACE;
+    else if (placement == "round_robin")
+      Config::global_config.channel_placement = ChannelPlacement::ROUND_ROBIN;
+    else if (placement == "min_latency")
+      Config::global_config.channel_placement = ChannelPlacement::MIN_LATENCY;
+    else if (placement == "capacity")
+      Config::global_config.channel_placement = ChannelPlacement::CAPACITY;
+    else if (placement == "lookahead")
+      Config::global_config.channel_placement = ChannelPlacement::LOOKAHEAD;
+    else {
+      spdlog::error("unknown channel_placement: {}", placement);
+      exit(-1);
+    }
+  }
 
   Config::global_config.kernel_fusion = sys_config["kernel_fusion"];
 
@@ -285,6 +451,197 @@ void initialize_system_config(std::string sys_config_path) {
   Config::global_config.max_batch_size = sys_config["max_batch_size"];
 
   Config::global_config.sub_batch_mode = sys_config["sub_batch_mode"];
+
+  Config::global_config.clock_skip = false;
+  if (sys_config.contains("clock_skip"))
+    Config::global_config.clock_skip = sys_config["clock_skip"];
+
+  Config::global_config.trace = false;
+  if (sys_config.contains("trace"))
+    Config::global_config.trace = sys_config["trace"];
+
+  Config::global_config.checkpoint_dir = "";
+  if (sys_config.contains("checkpoint_dir"))
+    Config::global_config.checkpoint_dir = sys_config["checkpoint_dir"];
+  Config::global_config.restore_checkpoint = "";
+  if (sys_config.contains("restore_checkpoint"))
+    Config::global_config.restore_checkpoint = sys_config["restore_checkpoint"];
+
+  Config::global_config.fast_forward = false;
+  if (sys_config.contains("fast_forward"))
+    Config::global_config.fast_forward = sys_config["fast_forward"];
+  Config::global_config.fast_forward_warmup = 2;
+  if (sys_config.contains("fast_forward_warmup"))
+    Config::global_config.fast_forward_warmup = sys_config["fast_forward_warmup"];
+  Config::global_config.fast_forward_tolerance = 0.01;
+  if (sys_config.contains("fast_forward_tolerance"))
+    Config::global_config.fast_forward_tolerance =
+        sys_config["fast_forward_tolerance"];
+  if (Config::global_config.fast_forward &&
+      !Config::global_config.sub_batch_mode) {
+    spdlog::warn("fast_forward is supported only in sub_batch_mode, ignored");
+    Config::global_config.fast_forward = false;
+  }
+
+  Config::global_config.tile_cache_size = 64;
+  if (sys_config.contains("tile_cache_size"))
+    Config::global_config.tile_cache_size = sys_config["tile_cache_size"];
+  Config::global_config.gemm_mapping = GemmMapping::HEURISTIC;
+  if (sys_config.contains("gemm_mapping")) {
+    std::string mapping = sys_config["gemm_mapping"];
+    if (mapping == "heuristic")
+      Config::global_config.gemm_mapping = GemmMapping::HEURISTIC;
+    else if (mapping == "search")
+      Config::global_config.gemm_mapping = GemmMapping::SEARCH;
+    else {
+      spdlog::error("unknown gemm_mapping: {}", mapping);
+      exit(-1);
+    }
+  }
+
+  Config::global_config.kv_block_rows = 1;
+  if (sys_config.contains("kv_block_rows"))
+    Config::global_config.kv_block_rows = sys_config["kv_block_rows"];
+  ast(Config::global_config.kv_block_rows > 0);
+
+  Config::global_config.continuous_batching = false;
+  if (sys_config.contains("continuous_batching"))
+    Config::global_config.continuous_batching =
+        sys_config["continuous_batching"];
+  if (Config::global_config.continuous_batching &&
+      Config::global_config.fast_forward) {
+    spdlog::warn("fast_forward is not supported with continuous_batching, "
+                 "ignored");
+    Config::global_config.fast_forward = false;
+  }
+  Config::global_config.request_output_size = 1;
+  if (sys_config.contains("request_output_size"))
+    Config::global_config.request_output_size =
+        sys_config["request_output_size"];
+  Config::global_config.request_arrival = ArrivalMode::BURST;
+  if (sys_config.contains("request_arrival")) {
+    std::string arrival = sys_config["request_arrival"];
+    if (arrival == "burst")
+      Config::global_config.request_arrival = ArrivalMode::BURST;
+    else if (arrival == "fixed")
+      Config::global_config.request_arrival = ArrivalMode::FIXED;
+    else if (arrival == "poisson")
+      Config::global_config.request_arrival = ArrivalMode::POISSON;
+    else if (arrival == "trace")
+      Config::global_config.request_arrival = ArrivalMode::TRACE;
+    else {
+      spdlog::error("unknown request_arrival: {}", arrival);
+      exit(-1);
+    }
+  }
+  Config::global_config.tile_dispatch = TileDispatch::ROUND_ROBIN;
+  if (sys_config.contains("tile_dispatch")) {
+    std::string dispatch = sys_config["tile_dispatch"];
+    if (dispatch == "round_robin")
+      Config::global_config.tile_dispatch = TileDispatch::ROUND_ROBIN;
+    else if (dispatch == "least_loaded")
+      Config::global_config.tile_dispatch = TileDispatch::LEAST_LOADED;
+    else if (dispatch == "channel_affinity")
+      Config::global_config.tile_dispatch = TileDispatch::CHANNEL_AFFINITY;
+    else {
+      spdlog::error("unknown tile_dispatch: {}", dispatch);
+      exit(-1);
+    }
+  }
+  Config::global_config.dram_ingress = IngressPolicy::PRIORITY;
+  if (sys_config.contains("dram_ingress")) {
+    std::string policy = sys_config["dram_ingress"];
+    if (policy == "priority")
+      Config::global_config.dram_ingress = IngressPolicy::PRIORITY;
+    else if (policy == "wrr")
+      Config::global_config.dram_ingress = IngressPolicy::WRR;
+    else if (policy == "deadline")
+      Config::global_config.dram_ingress = IngressPolicy::DEADLINE;
+    else if (policy == "pim_batch")
+      Config::global_config.dram_ingress = IngressPolicy::PIM_BATCH;
+    else {
+      spdlog::error("unknown dram_ingress: {}", policy);
+      exit(-1);
+    }
+  }
+  Config::global_config.ingress_priority = 1;
+  if (sys_config.contains("ingress_priority")) {
+    std::string priority = sys_config["ingress_priority"];
+    if (priority == "sa")
+      Config::global_config.ingress_priority = 1;
+    else if (priority == "pim")
+      Config::global_config.ingress_priority = 2;
+    else {
+      spdlog::error("unknown ingress_priority: {}", priority);
+      exit(-1);
+    }
+  }
+  Config::global_config.ingress_sa_weight = 1;
+  if (sys_config.contains("ingress_sa_weight"))
+    Config::global_config.ingress_sa_weight = sys_config["ingress_sa_weight"];
+  Config::global_config.ingress_pim_weight = 1;
+  if (sys_config.contains("ingress_pim_weight"))
+    Config::global_config.ingress_pim_weight = sys_config["ingress_pim_weight"];
+  ast(Config::global_config.ingress_sa_weight > 0 &&
+      Config::global_config.ingress_pim_weight > 0);
+  Config::global_config.ingress_deadline = 1000;
+  if (sys_config.contains("ingress_deadline"))
+    Config::global_config.ingress_deadline = sys_config["ingress_deadline"];
+  Config::global_config.ingress_batch = 32;
+  if (sys_config.contains("ingress_batch"))
+    Config::global_config.ingress_batch = sys_config["ingress_batch"];
+  ast(Config::global_config.ingress_batch > 0);
+  // priority keeps accepting both sub-batches in a cycle, a share of the
+  // bandwidth needs one grant per cycle
+  Config::global_config.ingress_grants =
+      Config::global_config.dram_ingress == IngressPolicy::PRIORITY ? 2 : 1;
+  if (sys_config.contains("ingress_grants"))
+    Config::global_config.ingress_grants = sys_config["ingress_grants"];
+  ast(Config::global_config.ingress_grants == 1 ||
+      Config::global_config.ingress_grants == 2);
+  Config::global_config.tp_allreduce = AllReduceAlgo::NONE;
+  if (sys_config.contains("tp_allreduce")) {
+    std::string algo = sys_config["tp_allreduce"];
+    if (algo == "none")
+      Config::global_config.tp_allreduce = AllReduceAlgo::NONE;
+    else if (algo == "ring")
+      Config::global_config.tp_allreduce = AllReduceAlgo::RING;
+    else if (algo == "tree")
+      Config::global_config.tp_allreduce = AllReduceAlgo::TREE;
+    else {
+      spdlog::error("unknown tp_allreduce: {}", algo);
+      exit(-1);
+    }
+  }
+  Config::global_config.tp_link_bandwidth = 300;
+  if (sys_config.contains("tp_link_bandwidth"))
+    Config::global_config.tp_link_bandwidth = sys_config["tp_link_bandwidth"];
+  Config::global_config.tp_link_latency = 1000;
+  if (sys_config.contains("tp_link_latency"))
+    Config::global_config.tp_link_latency = sys_config["tp_link_latency"];
+  ast(Config::global_config.tp_link_bandwidth > 0);
+  Config::global_config.pp_link_bandwidth = 64;
+  if (sys_config.contains("pp_link_bandwidth"))
+    Config::global_config.pp_link_bandwidth = sys_config["pp_link_bandwidth"];
+  Config::global_config.pp_link_latency = 2000;
+  if (sys_config.contains("pp_link_latency"))
+    Config::global_config.pp_link_latency = sys_config["pp_link_latency"];
+  ast(Config::global_config.pp_link_bandwidth > 0);
+  Config::global_config.request_qps = 0;
+  if (sys_config.contains("request_qps"))
+    Config::global_config.request_qps = sys_config["request_qps"];
+  if (Config::global_config.request_arrival == ArrivalMode::FIXED ||
+      Config::global_config.request_arrival == ArrivalMode::POISSON)
+    ast(Config::global_config.request_qps > 0);
+  Config::global_config.request_seed = 0;
+  if (sys_config.contains("request_seed"))
+    Config::global_config.request_seed = sys_config["request_seed"];
+  Config::global_config.slo_ttft_ms = 0;
+  if (sys_config.contains("slo_ttft_ms"))
+    Config::global_config.slo_ttft_ms = sys_config["slo_ttft_ms"];
+  Config::global_config.slo_tpot_ms = 0;
+  if (sys_config.contains("slo_tpot_ms"))
+    Config::global_config.slo_tpot_ms = sys_config["slo_tpot_ms"];
 }
 
 json load_config(std::string config_path) {
@@ -333,6 +690,26 @@ std::string opcodeTypeString(Opcode opcode) {
     return "PIM_READRES";
   case (Opcode::PIM_COMPS_READRES):
     return "PIM_COMPS_READRES";
+  case (Opcode::GEMM_PRELOAD):
+    return "GEMM_PRELOAD";
+  case (Opcode::GEMM):
+    return "GEMM";
+  case (Opcode::COMP):
+    return "COMP";
+  case (Opcode::IM2COL):
+    return "IM2COL";
+  case (Opcode::LAYERNORM):
+    return "LAYERNORM";
+  case (Opcode::GELU):
+    return "GELU";
+  case (Opcode::SOFTMAX):
+    return "SOFTMAX";
+  case (Opcode::ADD):
+    return "ADD";
+  case (Opcode::DUMMY):
+    return "DUMMY";
+  case (Opcode::ALLREDUCE):
+    return "ALLREDUCE";
   default:
     return "Unknown";
   }
@@ -371,6 +748,9 @@ std::string Instruction::repr() {
   case (Opcode::DUMMY):
     ret += "DUMMY";
     break;
+  case (Opcode::ALLREDUCE):
+    ret += "ALLREDUCE";
+    break;
   }
   ret += " / src_addrs.size() : ";
   ret += std::to_string(src_addrs.size());
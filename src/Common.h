@@ -8,6 +8,7 @@
 #include <robin_hood.h>
 
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <cmath>
 #include <cstdint>
@@ -19,6 +20,7 @@
 #include <set>
 #include <sstream>
 #include <string>
+#include <type_traits>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -68,6 +70,7 @@ uint64_t encode_pim_comps_readres(int ch, int row, int num_comps,
                                   bool last_cmd);
 
 addr_type switch_co_ch(addr_type addr);
+addr_type unswitch_co_ch(addr_type addr); // inverse of switch_co_ch
 } // namespace AddressConfig
 
 enum class Color { RED, GREEN, YELLOW, BLUE, MAGENTA, CYAN, DEFAULT };
@@ -92,21 +95,179 @@ enum class Opcode {
   PIM_READRES,
   PIM_COMPS_READRES,
   DUMMY,
+  ALLREDUCE, // all-reduce of a partial sum with the other n_tp devices
   SIZE
 };
 
 struct Tile;
 
+// Address list of an instruction as runs of (base, stride, count) instead of
+// one entry per address. Tensor rows and PIM rows are strided, so thousands of
+// DRAM addresses take a few runs. Iteration yields the same addresses in order.
+// Up to kInlineRanges runs are stored in place, so copying an instruction on
+// the issue path does not allocate; longer lists spill to the heap.
+class AddrList {
+public:
+  struct Range {
+    addr_type base;
+    addr_type stride; // wraps around for decreasing addresses
+    uint32_t count;
+  };
+  static constexpr uint32_t kInlineRanges = 2;
+
+  class const_iterator {
+  public:
+    const_iterator(const Range *range, uint32_t idx) : _range(range), _idx(idx) {}
+    addr_type operator*() const { return _range->base + _range->stride * _idx; }
+    const_iterator &operator++() {
+      if (++_idx == _range->count) {
+        _range++;
+        _idx = 0;
+      }
+      return *this;
+    }
+    bool operator==(const const_iterator &o) const {
+      return _range == o._range && _idx == o._idx;
+    }
+    bool operator!=(const const_iterator &o) const { return !(*this == o); }
+
+  private:
+    const Range *_range;
+    uint32_t _idx;
+  };
+
+  struct RangeView {
+    const Range *first;
+    const Range *last;
+    const Range *begin() const { return first; }
+    const Range *end() const { return last; }
+    size_t size() const { return last - first; }
+  };
+
+  AddrList() : _size(0), _n_ranges(0) {}
+  AddrList(const std::vector<addr_type> &addrs) : AddrList() {
+    for (addr_type addr : addrs)
+      push_back(addr);
+  }
+  // leaves addrs empty like a moved-from vector (some callers rely on it)
+  AddrList(std::vector<addr_type> &&addrs) : AddrList(addrs) { addrs.clear(); }
+  AddrList(std::initializer_list<addr_type> addrs) : AddrList() {
+    for (addr_type addr : addrs)
+      push_back(addr);
+  }
+  AddrList(const AddrList &) = default;
+  AddrList &operator=(const AddrList &) = default;
+  // moved-from lists are empty as well
+  AddrList(AddrList &&o) noexcept
+      : _inline(o._inline), _spill(std::move(o._spill)), _size(o._size),
+        _n_ranges(o._n_ranges) {
+    o.clear();
+  }
+  AddrList &operator=(AddrList &&o) noexcept {
+    _inline = o._inline;
+    _spill = std::move(o._spill);
+    _size = o._size;
+    _n_ranges = o._n_ranges;
+    o.clear();
+    return *this;
+  }
+
+  void push_back(addr_type addr) {
+    _size++;
+    if (_n_ranges > 0) {
+      Range &last = data()[_n_ranges - 1];
+      if (last.count == 1) {
+        last.stride = addr - last.base;
+        last.count++;
+        return;
+      }
+      if (last.base + last.stride * last.count == addr) {
+        last.count++;
+        return;
+      }
+    }
+    append(Range{addr, 0, 1});
+  }
+  // count addresses from base by stride
+  void push_range(addr_type base, addr_type stride, uint32_t count) {
+    if (count == 0)
+      return;
+    _size += count;
+    append(Range{base, stride, count});
+  }
+  void clear() {
+    _spill.clear();
+    _size = 0;
+    _n_ranges = 0;
+  }
+
+  size_t size() const { return _size; }
+  bool empty() const { return _size == 0; }
+  addr_type front() const { return data()[0].base; }
+  RangeView ranges() const { return RangeView{data(), data() + _n_ranges}; }
+  const_iterator begin() const { return const_iterator(data(), 0); }
+  const_iterator end() const { return const_iterator(data() + _n_ranges, 0); }
+
+private:
+  Range *data() {
+    return _n_ranges > kInlineRanges ? _spill.data() : _inline.data();
+  }
+  const Range *data() const {
+    return _n_ranges > kInlineRanges ? _spill.data() : _inline.data();
+  }
+  void append(Range range) {
+    if (_n_ranges < kInlineRanges) {
+      _inline[_n_ranges] = range;
+    } else {
+      if (_n_ranges == kInlineRanges)
+        _spill.assign(_inline.begin(), _inline.end());
+      _spill.push_back(range);
+    }
+    _n_ranges++;
+  }
+
+  std::array<Range, kInlineRanges> _inline;
+  std::vector<Range> _spill; // all runs once there are more than kInlineRanges
+  size_t _size;
+  uint32_t _n_ranges;
+};
+
+// Index of a tile issued to a core in TileTable. Instructions and memory
+// accesses refer to their tile by this handle instead of a weak_ptr<Tile>, so
+// copying them does not touch reference counts. A handle whose tile has been
+// released resolves to nullptr.
+struct TileHandle {
+  uint32_t index = 0;
+  uint32_t generation = 0; // 0: no tile
+  Tile *get() const;
+};
+
+class TileTable {
+public:
+  static TileHandle add(Ptr<Tile> tile);
+  static void remove(TileHandle handle);
+  static Tile *get(TileHandle handle) {
+    if (handle.generation == 0 || handle.index >= _generations.size() ||
+        _generations[handle.index] != handle.generation)
+      return nullptr;
+    return _tiles[handle.index].get();
+  }
+
+private:
+  static std::vector<Ptr<Tile>> _tiles;
+  static std::vector<uint32_t> _generations;
+  static std::vector<uint32_t> _free_slots;
+};
+
+inline Tile *TileHandle::get() const { return TileTable::get(*this); }
+
 struct Instruction {
   Opcode opcode;
   cycle_type start_cycle;
   cycle_type finish_cycle;
-  std::string id;
-  std::vector<std::string> dependent_ids;
-  std::string dest_id;
   addr_type dest_addr;
   uint32_t size;
-  std::vector<addr_type> src_addrs;
+  AddrList src_addrs;
   int spad_id;
   int accum_spad_id;
   uint32_t operand_id = 0;
@@ -125,7 +286,7 @@ struct Instruction {
 
   bool is_pim_inst = false;
 
-  std::weak_ptr<Tile> parent_tile;
+  TileHandle parent_tile;
 
   std::string repr();
 };
@@ -167,6 +328,7 @@ struct Tile { //这个是NPU里面的基本调度和执行单元
   // 5. 硬件资源映射 (Resource Mapping)
   int spad_id;       // 输入缓冲区 ID (用于双缓冲 Ping-Pong)
   int accum_spad_id; // 累加缓冲区 ID
+  Dataflow dataflow = Dataflow::WS; // 脉动阵列数据流 (由 optype 选择)
 
   // initialized when Tile moves into core.
 
@@ -182,6 +344,9 @@ struct Tile { //这个是NPU里面的基本调度和执行单元
   // populate accurate memory request when store instruction is decoded
   uint32_t remaining_accum_io; // 还有多少个累加/写回指令没完成？(等待 SRAM ->
                                // DRAM 或 累加器操作)
+  // MOVOUTs not yet read out of the accum spad. The accum spad buffer can be
+  // reused once they are sent, before the writes are acknowledged
+  uint32_t remaining_stores; // 还有多少个写回指令没从累加缓冲区读出
   // 只有当这三个计数器都归零时，这个Tile才算真正执行完毕。
 
   // 平台标识 (Platform)
@@ -192,6 +357,7 @@ struct Tile { //这个是NPU里面的基本调度和执行单元
   // 的混合执行模型。它标记了这个任务包是应该发送给 NPU 的脉动阵列（Systolic
   // Array）执行，还是发送给 PIM 单元执行。 这也对应了
   // Simulator.cc中看到的双发射队列逻辑。
+  TileHandle handle; // TileTable entry while the tile runs on a core
   std::string repr(); // 定义在Common.cc里面 用于打印Tile信息
 };
 
@@ -209,6 +375,25 @@ enum class MemoryAccessType {
 std::string memAccessTypeString(MemoryAccessType type);
 std::string opcodeTypeString(Opcode opcode);
 
+// slab/free-list pool backing MemoryAccess (one object per 32B/64B request).
+// objects deleted after their response is consumed are recycled, so peak
+// memory is bounded by in-flight requests instead of the trace length.
+class MemoryAccessPool {
+public:
+  static void *allocate();
+  static void release(void *ptr);
+  static size_t in_use() { return _in_use; }
+  static size_t peak() { return _peak; }
+  static size_t capacity();
+
+private:
+  static constexpr size_t _slab_objects = 4096;
+  static std::vector<void *> _slabs;
+  static std::vector<void *> _free_list;
+  static size_t _in_use;
+  static size_t _peak;
+};
+
 typedef struct MemoryAccess {
   static int req_count;
   static int pre_req_count;
@@ -223,6 +408,7 @@ typedef struct MemoryAccess {
   cycle_type start_cycle;
   cycle_type dram_enter_cycle;
   cycle_type dram_finish_cycle;
+  cycle_type icnt_enter_cycle; // icnt cycle of the last push into the icnt
   int buffer_id;
 
   static std::vector<MemoryAccess *>
@@ -231,19 +417,31 @@ typedef struct MemoryAccess {
                    cycle_type start_cycle, int buffer_id,
                    StagePlatform stage_platform);
 
-  std::weak_ptr<Tile> parent_tile;
+  TileHandle parent_tile;
   // SA program / PIM program (for sub-batch interleaving)
   StagePlatform stage_platform;
 
+  static void *operator new(size_t size) {
+    assert(size == sizeof(MemoryAccess));
+    return MemoryAccessPool::allocate();
+  }
+  static void operator delete(void *ptr) { MemoryAccessPool::release(ptr); }
+
   static void log_count() {
     spdlog::info("total pre req count {} / memory request count {}",
                  pre_req_count, req_count);
+    spdlog::info("memory access pool peak {} / in use {} / capacity {}",
+                 MemoryAccessPool::peak(), MemoryAccessPool::in_use(),
+                 MemoryAccessPool::capacity());
   }
 
 } MemoryAccess;
 
 uint32_t generate_id();
 uint32_t generate_mem_access_id();
+// checkpoint of the global counters above and of MemoryAccess address state
+void save_global_state(json &j);
+void load_global_state(const json &j);
 json load_config(std::string config_path);
 SimulationConfig initialize_config(json config); // npu config
 void initialize_memory_config(std::string mem_config_path);
@@ -267,8 +465,8 @@ class BTensor;
 typedef struct {
   // client to scheduler.
   uint32_t id;
-  uint32_t arrival_cycle;   // time spend on client == arrival time to scheduler
-  uint32_t completed_cycle; // return time to client
+  cycle_type arrival_cycle; // time spend on client == arrival time to scheduler
+  cycle_type completed_cycle; // return time to client
 
   // request demand
   uint32_t input_size;  // input sequence length
@@ -283,6 +481,8 @@ typedef struct {
   std::vector<Ptr<BTensor>> K_cache;
   std::vector<Ptr<BTensor>> V_cache;
 
+  // cycle at which each output token is generated (latency stat)
+  std::vector<cycle_type> token_cycles = {};
 } InferRequest;
 
 void print_backtrace();
@@ -98,8 +98,9 @@ void Core::issue(Tile &in_tile) {
   tile->remaining_loads = 0;
   tile->remaining_computes = 0;
   tile->remaining_accum_io = 0;
+  tile->handle = TileTable::add(tile);
   for (auto &inst : tile->instructions) {
-    inst.parent_tile = std::weak_ptr<Tile>(tile);
+    inst.parent_tile = tile->handle;
     inst.spad_id = tile->spad_id;
     inst.accum_spad_id = tile->accum_spad_id;
     Sram *buffer;
@@ -155,6 +156,7 @@ Ptr<Tile> Core::pop_finished_tile() {
   auto result = _finished_tiles.front();
   result->stat.end_cycle = _core_cycle;
   _finished_tiles.pop();
+  TileTable::remove(result->handle);
   return result;
 }
 
@@ -219,7 +221,7 @@ void Core::push_memory_response(MemoryAccess *response) {
 
   bool is_write = response->req_type == MemoryAccessType::WRITE;
   bool is_read = response->req_type == MemoryAccessType::READ;
-  if (auto tile = response->parent_tile.lock()) {
+  if (auto tile = response->parent_tile.get()) {
     if (is_write) {
       tile->remaining_accum_io--;
     } else {
@@ -7,6 +7,8 @@
 PIM::PIM(SimulationConfig config)
     : _mem(std::make_unique<dramsim3::NewtonSim>(config.pim_config_path, config.log_dir)) {
     _total_processed_requests.resize(config.dram_channels);
+    _burst_open.resize(config.dram_channels, false);
+    _burst_start_cycle.resize(config.dram_channels, 0);
     _processed_requests.resize(config.dram_channels);
 
     for (int ch = 0; ch < config.dram_channels; ch++) {
@@ -14,6 +16,11 @@ PIM::PIM(SimulationConfig config)
         _processed_requests[ch] = 0;
     }
 
+    std::vector<std::string> columns = {"cycle"};
+    for (int ch = 0; ch < config.dram_channels; ch++)
+        columns.push_back("ch" + std::to_string(ch));
+    _bw_util_stat = &StatRegistry::GetInstance()->time_series("dram", "bw_util", columns);
+
     _stat_interval = 1000;
     _stats.resize(config.dram_channels);
     for (size_t i = 0; i < config.dram_channels; ++i) {
@@ -49,12 +56,15 @@ void PIM::cycle() {
     int interval = 10000;
     if (_cycles % interval == 0) {
         spdlog::debug("-------------DRAM BW Check--------------");
+        std::vector<double> row = {(double)_cycles};
         for (int ch = 0; ch < _config.dram_channels; ch++) {
             float util = ((float)_processed_requests[ch] * _burst_cycle) / interval * 100; //这里统计带宽利用率
             spdlog::debug("DRAM CH[{}]: BW Util {:.2f}%", ch, util);
+            row.push_back(util);
             _total_processed_requests[ch] += _processed_requests[ch];
             _processed_requests[ch] = 0;
         }
+        _bw_util_stat->append(row);
     }
 
     // update stats
@@ -109,7 +119,14 @@ void PIM::push(uint32_t cid, MemoryAccess *request) {
     request->request = false;
 
     _mem_req_cnt++;
+    if (request->req_type == MemoryAccessType::P_HEADER && _config.trace && !_burst_open[cid]) {
+        _burst_open[cid] = true;
+        _burst_start_cycle[cid] = _cycles;
+    }
     _mem->AddTransaction(target_addr, int(request->req_type), request);
+
+    // pim_header request does not receive response, so nobody else will free it
+    if (request->req_type == MemoryAccessType::P_HEADER) delete request;
 }
 
 bool PIM::is_empty(uint32_t cid) {
@@ -154,11 +171,71 @@ void PIM::update_stat(uint32_t cid) {
 void PIM::pop(uint32_t cid) {
     // make sure update stat before mem-pop
     update_stat(cid);
+    trace_burst(cid);
 
     assert(!is_empty(cid));
     _mem->Pop(cid);
 }
 
+// a PIM burst of the channel lasts from its first header to the result read
+void PIM::trace_burst(uint32_t cid) {
+    if (!_burst_open[cid]) return;
+    auto type = top(cid)->req_type;
+    if (type != MemoryAccessType::READRES && type != MemoryAccessType::COMPS_READRES) return;
+    Tracer::GetInstance()->complete(TRACE_PID_DRAM, cid, "PIM",
+                                    Tracer::dram_us(_burst_start_cycle[cid]),
+                                    Tracer::dram_us(_cycles - _burst_start_cycle[cid]));
+    _burst_open[cid] = false;
+}
+
+cycle_type PIM::cycles_to_next_event() {
+    for (int ch = 0; ch < _config.dram_channels; ch++) {
+        if (!_mem->IsEmpty(ch)) return 0;
+    }
+    return std::numeric_limits<cycle_type>::max();
+}
+
+bool PIM::idle() { return _mem->IsIdle(); }
+
+void PIM::save_state(json &j, std::string mem_state_path) {
+    j["cycles"] = _cycles;
+    j["stage_cycles"] = _stage_cycles;
+    j["total_done_requests"] = _total_done_requests;
+    j["mem_req_cnt"] = _mem_req_cnt;
+    j["processed_requests"] = _processed_requests;
+    j["total_processed_requests"] = _total_processed_requests;
+    // stat windows of the current stage (logged when the stage stat is updated)
+    j["stats"] = json::array();
+    for (auto &stats : _stats) {
+        json ch_stats = json::array();
+        for (auto &stat : stats)
+            ch_stats.push_back(
+                {stat.start_cycle, stat.memory_reads, stat.memory_writes, stat.pim_reads});
+        j["stats"].push_back(ch_stats);
+    }
+    _mem->SaveState(mem_state_path);
+}
+
+void PIM::load_state(const json &j, std::string mem_state_path) {
+    _cycles = j["cycles"];
+    _stage_cycles = j["stage_cycles"];
+    _total_done_requests = j["total_done_requests"];
+    _mem_req_cnt = j["mem_req_cnt"];
+    _processed_requests = j["processed_requests"].get<std::vector<uint64_t>>();
+    _total_processed_requests = j["total_processed_requests"].get<std::vector<uint64_t>>();
+    ast(j["stats"].size() == _stats.size());
+    for (size_t ch = 0; ch < _stats.size(); ++ch) {
+        _stats[ch].clear();
+        for (auto &stat : j["stats"][ch]) {
+            _stats[ch].push_back(MemoryIOStat(stat[0], ch, _stat_interval));
+            _stats[ch].back().memory_reads = stat[1];
+            _stats[ch].back().memory_writes = stat[2];
+            _stats[ch].back().pim_reads = stat[3];
+        }
+    }
+    _mem->LoadState(mem_state_path);
+}
+
 uint32_t PIM::get_channel_id(MemoryAccess *access) {
     // spdlog::info("pim get_channel_id()");
     return _mem->GetChannel(access->dram_address);
@@ -7,6 +7,8 @@
 #include "Common.h"
 #include "Logger.h"
 #include "Stat.h"
+#include "StatRegistry.h"
+#include "Tracer.h"
 #include "newtonsim/NewtonSim.h"
 
 class Dram {
@@ -27,6 +29,15 @@ class Dram {
     virtual void reset_pim_cycle() = 0;
     virtual void log(Stage stage) = 0;
 
+    // event-driven clock skipping: DRAM state is advanced every dram cycle (refresh, bank
+    // timing), so it is never skipped. it only reports whether a response is ready (0).
+    virtual cycle_type cycles_to_next_event() = 0;
+
+    // checkpoint at a stage boundary. memory controller state is saved to its own file
+    virtual bool idle() = 0;
+    virtual void save_state(json &j, std::string mem_state_path) = 0;
+    virtual void load_state(const json &j, std::string mem_state_path) = 0;
+
    protected:
     SimulationConfig _config;
     uint32_t _n_ch;
@@ -47,6 +58,10 @@ class PIM : public Dram {
     virtual void pop(uint32_t cid) override;
     virtual uint32_t get_channel_id(MemoryAccess *request) override;
     virtual void print_stat() override;
+    virtual cycle_type cycles_to_next_event() override;
+    virtual bool idle() override;
+    virtual void save_state(json &j, std::string mem_state_path) override;
+    virtual void load_state(const json &j, std::string mem_state_path) override;
 
     uint64_t MakeAddress(int channel, int rank, int bankgroup, int bank, int row, int col);
     uint64_t EncodePIMHeader(int channel, int row, bool for_gwrite, int num_comps, int num_readres);
@@ -60,6 +75,11 @@ class PIM : public Dram {
     int _burst_cycle;
     std::vector<std::vector<MemoryIOStat>> _stats;
     uint64_t _stat_interval;
+    StatRegistry::TimeSeries *_bw_util_stat;  // bandwidth util of each channel per 10000 cycles
+    // trace: PIM burst of each channel (P_HEADER -> READRES)
+    std::vector<bool> _burst_open;
+    std::vector<cycle_type> _burst_start_cycle;
+    void trace_burst(uint32_t cid);
 
     // stats
     uint64_t _stage_cycles;
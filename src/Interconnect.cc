@@ -41,7 +41,227 @@ void Interconnect::update_stat(MemoryAccess memory_access, uint64_t ch_idx) {
     }
 }
 
-SimpleInterconnect::SimpleInterconnect(SimulationConfig config) : _latency(config.icnt_latency) {
+void Interconnect::update_stat_interval() {
+    for (auto ch_idx = 0; ch_idx < _config.dram_channels; ++ch_idx) {
+        if (_stats[ch_idx].back().start_cycle + _mem_cycle_interval < get_core_cycle()) {
+            auto stat = MemoryIOStat((get_core_cycle() / _mem_cycle_interval) * _mem_cycle_interval,
+                                     ch_idx, _mem_cycle_interval);
+            _stats[ch_idx].push_back(stat);
+        }
+    }
+}
+
+void Interconnect::push_memreq(uint32_t mem_ch, MemoryAccess *mem_req) {
+    if (!_config.sub_batch_mode) {
+        // When single buffer PIM (Newton), there is single batch,
+        // so use one interconnect queue.
+        mem_req->stage_platform = StagePlatform::SA;
+    }
+    assert(mem_req->stage_platform == StagePlatform::SA ||
+           mem_req->stage_platform == StagePlatform::PIM);
+    if (mem_req->stage_platform == StagePlatform::SA)
+        _mem_req_queue1[mem_ch].push(mem_req);
+    else if (mem_req->stage_platform == StagePlatform::PIM)
+        _mem_req_queue2[mem_ch].push(mem_req);
+    else
+        exit(-1);
+}
+
+void Interconnect::record_delivery(MemoryAccess *access) {
+    _latency_stat.add(_cycles - access->icnt_enter_cycle);
+}
+
+void Interconnect::print_latency_stats() {
+    if (_latency_stat.count == 0) return;
+    spdlog::info("Interconnect : {} packets, avg latency {:.2f} cycles, max latency {} cycles",
+                 _latency_stat.count, _latency_stat.mean(), _latency_stat.max);
+}
+
+uint32_t Interconnect::get_packet_size(MemoryAccess *access) {
+    bool write = access->req_type == MemoryAccessType::WRITE ||
+                 access->req_type == MemoryAccessType::GWRITE;
+    if (write == access->request) return access->size;
+    return _ctrl_size;
+}
+
+// below 3 method is used to send "Memory request" to "Dram" in "Interconnect"
+// - has_memreq
+// - memreq_top
+// - memreq_pop
+
+bool Interconnect::has_memreq1(uint32_t cid) { return !_mem_req_queue1[cid].empty(); }
+bool Interconnect::has_memreq2(uint32_t cid) { return !_mem_req_queue2[cid].empty(); }
+
+MemoryAccess *Interconnect::memreq_top1(uint32_t cid) {
+    assert(has_memreq1(cid));
+    return _mem_req_queue1[cid].front();
+}
+MemoryAccess *Interconnect::memreq_top2(uint32_t cid) {
+    assert(has_memreq2(cid));
+    return _mem_req_queue2[cid].front();
+}
+
+void Interconnect::memreq_pop1(uint32_t cid) {
+    assert(has_memreq1(cid));
+    _mem_req_queue1[cid].pop();
+}
+
+void Interconnect::memreq_pop2(uint32_t cid) {
+    assert(has_memreq2(cid));
+    _mem_req_queue2[cid].pop();
+}
+
+bool Interconnect::has_memreq(uint32_t cid, uint32_t sub_batch) {
+    return sub_batch == 1 ? has_memreq1(cid) : has_memreq2(cid);
+}
+
+MemoryAccess *Interconnect::memreq_top(uint32_t cid, uint32_t sub_batch) {
+    return sub_batch == 1 ? memreq_top1(cid) : memreq_top2(cid);
+}
+
+void Interconnect::memreq_pop(uint32_t cid, uint32_t sub_batch) {
+    if (sub_batch == 1)
+        memreq_pop1(cid);
+    else
+        memreq_pop2(cid);
+}
+
+uint32_t Interconnect::memreq_order(uint32_t cid, uint32_t order[2]) {
+    auto &ingress = _ingress[cid];
+    bool waiting1 = has_memreq1(cid);
+    bool waiting2 = has_memreq2(cid);
+    if (!waiting1 && !waiting2) return 0;
+
+    uint32_t first = _config.ingress_priority;
+    bool exclusive = false;
+    switch (_config.dram_ingress) {
+        case IngressPolicy::PRIORITY:
+            break;
+        case IngressPolicy::WRR:
+            first = ingress.turn;
+            break;
+        case IngressPolicy::DEADLINE: {
+            // icnt_enter_cycle of a waiting head is its push into the icnt
+            bool late1 = waiting1 &&
+                         _cycles - memreq_top1(cid)->icnt_enter_cycle >= _config.ingress_deadline;
+            bool late2 = waiting2 &&
+                         _cycles - memreq_top2(cid)->icnt_enter_cycle >= _config.ingress_deadline;
+            if (late1 && late2)
+                first = memreq_top1(cid)->icnt_enter_cycle <= memreq_top2(cid)->icnt_enter_cycle
+                            ? 1
+                            : 2;
+            else if (late1)
+                first = 1;
+            else if (late2)
+                first = 2;
+            break;
+        }
+        case IngressPolicy::PIM_BATCH:
+            // the other sub-batch waits for the turn, so PIM commands and SA accesses
+            // are not interleaved in the channel
+            first = ingress.turn;
+            exclusive = has_memreq(cid, first);
+            break;
+    }
+
+    uint32_t n = 0;
+    uint32_t second = 3 - first;
+    if (has_memreq(cid, first)) order[n++] = first;
+    if (!exclusive && has_memreq(cid, second)) order[n++] = second;
+    return n;
+}
+
+void Interconnect::memreq_arbitrated(uint32_t cid, const bool tried[2], const bool granted[2]) {
+    auto &ingress = _ingress[cid];
+    for (uint32_t i = 0; i < 2; i++) {
+        if (granted[i]) {
+            ingress.grants[i]++;
+            ingress.stall_run[i] = 0;
+        } else if (has_memreq(cid, i + 1)) {
+            if (tried[i])
+                ingress.full_cycles[i]++;
+            else
+                ingress.held_cycles[i]++;
+            ingress.stall_run[i]++;
+            ingress.max_stall[i] = MAX(ingress.max_stall[i], ingress.stall_run[i]);
+        } else {
+            ingress.stall_run[i] = 0;
+        }
+    }
+
+    if (_config.dram_ingress != IngressPolicy::WRR &&
+        _config.dram_ingress != IngressPolicy::PIM_BATCH)
+        return;
+    uint32_t turn = ingress.turn;
+    uint32_t quota = _config.ingress_batch;
+    if (_config.dram_ingress == IngressPolicy::WRR)
+        quota = turn == 1 ? _config.ingress_sa_weight : _config.ingress_pim_weight;
+    if (granted[turn - 1]) ingress.served++;
+    // hand over the turn when its quota is used or it has nothing to send
+    if (ingress.served >= quota || !has_memreq(cid, turn)) {
+        if (has_memreq(cid, 3 - turn)) ingress.turn = 3 - turn;
+        ingress.served = 0;
+    }
+}
+
+// stalls of each sub-batch at the dram ingress: held by the arbiter or blocked by a full
+// dram queue
+void Interconnect::print_ingress_stats() {
+    std::string fname = Config::global_config.log_dir + "/_ingress.tsv";
+    std::ofstream ofile(fname);
+    if (!ofile.is_open()) {
+        assert(0);
+    }
+    ofile << "channel\tsub_batch\tgrants\theld_cycles\tfull_cycles\tmax_stall_cycles\n";
+    uint64_t stall_cycles[2] = {0, 0};
+    uint64_t max_stall[2] = {0, 0};
+    for (uint32_t ch = 0; ch < _ingress.size(); ch++) {
+        auto &ingress = _ingress[ch];
+        for (uint32_t i = 0; i < 2; i++) {
+            ofile << ch << "\t" << (i == 0 ? "SA" : "PIM") << "\t" << ingress.grants[i] << "\t"
+                  << ingress.held_cycles[i] << "\t" << ingress.full_cycles[i] << "\t"
+                  << ingress.max_stall[i] << "\n";
+            stall_cycles[i] += ingress.held_cycles[i] + ingress.full_cycles[i];
+            max_stall[i] = MAX(max_stall[i], ingress.max_stall[i]);
+        }
+    }
+    ofile.close();
+    spdlog::info("DRAM ingress : SA stalled {} cycles (max {}), PIM stalled {} cycles (max {})",
+                 stall_cycles[0], max_stall[0], stall_cycles[1], max_stall[1]);
+}
+
+void Interconnect::save_ingress_state(json &j) {
+    j = json::array();
+    for (auto &ingress : _ingress) {
+        j.push_back({ingress.turn, ingress.served,
+                     {ingress.grants[0], ingress.grants[1]},
+                     {ingress.held_cycles[0], ingress.held_cycles[1]},
+                     {ingress.full_cycles[0], ingress.full_cycles[1]},
+                     {ingress.max_stall[0], ingress.max_stall[1]}});
+    }
+}
+
+void Interconnect::load_ingress_state(const json &j) {
+    ast(j.size() == _ingress.size());
+    for (size_t ch = 0; ch < _ingress.size(); ++ch) {
+        auto &ingress = _ingress[ch];
+        auto &state = j[ch];
+        ingress.turn = state[0];
+        ingress.served = state[1];
+        for (uint32_t i = 0; i < 2; i++) {
+            ingress.grants[i] = state[2][i];
+            ingress.held_cycles[i] = state[3][i];
+            ingress.full_cycles[i] = state[4][i];
+            ingress.max_stall[i] = state[5][i];
+            ingress.stall_run[i] = 0;
+        }
+    }
+}
+
+SimpleInterconnect::SimpleInterconnect(SimulationConfig config)
+    : _latency(config.icnt_latency),
+      _bandwidth(config.icnt_bandwidth),
+      _buffer_size(config.icnt_buffer_size) {
     spdlog::info("Initialize SimpleInterconnect");
     _cycles = 0;
     _config = config;
@@ -50,14 +270,12 @@ SimpleInterconnect::SimpleInterconnect(SimulationConfig config) : _latency(confi
     _in_buffers.resize(_n_nodes);
     _out_buffers.resize(config.num_cores * config.dram_channels);
 
-    _mem_sa_q_turn = true;
     _mem_req_queue1.resize(config.dram_channels);  // for SA
     _mem_req_queue2.resize(config.dram_channels);  // for PIM
+    _ingress.resize(config.dram_channels);
 
-    _busy_node.resize(_n_nodes);
-    for (int node = 0; node < _n_nodes; node++) {
-        _busy_node[node] = false;
-    }
+    _links.resize(_n_nodes);
+    _grant.resize(_n_nodes, -1);
     // TODO: make it configurable
     _mem_cycle_interval = 250;
     _stats.resize(config.dram_channels);
@@ -69,59 +287,155 @@ SimpleInterconnect::SimpleInterconnect(SimulationConfig config) : _latency(confi
 bool SimpleInterconnect::running() { return false; }
 
 void SimpleInterconnect::cycle() {
-    for (int node = 0; node < _n_nodes; node++) {
-        // std::cout << "in buffer " << node << " : " << _in_buffers[node].size() << std::endl;
-        // std::cout << "out buffer " << node << " : " << _out_buffers[node].size() << std::endl;
-    }
-    // in_bufs -> out_bufs
-    // one of core -> dram or dram -> core is possible.
-    for (int node = 0; node < _n_nodes; node++) {
-        int src_node = (_rr_start + node) % _n_nodes;
-        if (!_in_buffers[src_node].empty() &&
-            _in_buffers[src_node].front().finish_cycle <= _cycles) {
-            uint32_t dest = _in_buffers[src_node].front().dest;
-            if (!_busy_node[dest]) {
-                if (dest < _dram_offset) {
-                    _out_buffers[dest].push(_in_buffers[src_node].front().access);
-                } else {
-                    uint32_t mem_ch = dest - _dram_offset;
-                    MemoryAccess *mem_req = _in_buffers[src_node].front().access;
-                    if (!_config.sub_batch_mode) {
-                        // When single buffer PIM (Newton), there is single batch,
-                        // so use one interconnect queue.
-                        mem_req->stage_platform = StagePlatform::SA;
-                    }
-                    assert(mem_req->stage_platform == StagePlatform::SA ||
-                           mem_req->stage_platform == StagePlatform::PIM);
-                    if (mem_req->stage_platform == StagePlatform::SA)
-                        _mem_req_queue1[mem_ch].push(mem_req);
-                    else if (mem_req->stage_platform == StagePlatform::PIM)
-                        _mem_req_queue2[mem_ch].push(mem_req);
-                    else
-                        exit(-1);
-                }
-                _in_buffers[src_node].pop();
-                _busy_node[dest] = true;
-                // spdlog::_log_filece("PUSH TO OUTBUFFER {} {}", src_node, dest);
-            }
-        }
+    // arbitration: each free link grants the ready in-buffer head closest to its
+    // round-robin pointer
+    for (uint32_t src = 0; src < _n_nodes; src++) {
+        if (_in_buffers[src].empty() || _in_buffers[src].front().finish_cycle > _cycles)
+            continue;
+        uint32_t dest = _in_buffers[src].front().dest;
+        auto &link = _links[dest];
+        if (link.free_cycle > _cycles) continue;
+        int granted = _grant[dest];
+        if (granted < 0 || (src + _n_nodes - link.rr_next) % _n_nodes <
+                               (granted + _n_nodes - link.rr_next) % _n_nodes)
+            _grant[dest] = src;
     }
 
-    for (auto ch_idx = 0; ch_idx < _config.dram_channels; ++ch_idx) {
-        if (_stats[ch_idx].back().start_cycle + _mem_cycle_interval < get_core_cycle()) {
-            auto stat = MemoryIOStat((get_core_cycle() / _mem_cycle_interval) * _mem_cycle_interval,
-                                     ch_idx, _mem_cycle_interval);
-            _stats[ch_idx].push_back(stat);
-        }
+    // in_bufs -> links
+    for (uint32_t dest = 0; dest < _n_nodes; dest++) {
+        if (_grant[dest] < 0) continue;
+        uint32_t src = _grant[dest];
+        _grant[dest] = -1;
+        auto &entity = _in_buffers[src].front();
+        auto &link = _links[dest];
+        cycle_type link_cycles = get_link_cycles(entity.access);
+        link.free_cycle = _cycles + link_cycles;
+        link.rr_next = (src + 1) % _n_nodes;
+        link.in_flight.push({_cycles + link_cycles - 1, entity.access});
+        link.packets++;
+        link.bytes += get_packet_size(entity.access);
+        link.busy_cycles += link_cycles;
+        link.queueing_cycles += _cycles - entity.finish_cycle;
+        _in_buffers[src].pop();
     }
 
-    for (int node = 0; node < _n_nodes; node++) {
-        _busy_node[node] = false;
+    // links -> out_bufs
+    for (uint32_t dest = 0; dest < _n_nodes; dest++) {
+        auto &in_flight = _links[dest].in_flight;
+        while (!in_flight.empty() && in_flight.front().first <= _cycles) {
+            deliver(dest, in_flight.front().second);
+            in_flight.pop();
+        }
     }
-    _rr_start = (_rr_start + 1) % _n_nodes;
+
+    update_stat_interval();
     _cycles++;
 }
 
+void SimpleInterconnect::deliver(uint32_t dest, MemoryAccess *access) {
+    if (dest < _dram_offset) {
+        _out_buffers[dest].push(access);
+    } else {
+        push_memreq(dest - _dram_offset, access);
+    }
+    record_delivery(access);
+}
+
+// a packet holds the link for ceil(size / bandwidth) cycles, at least one
+cycle_type SimpleInterconnect::get_link_cycles(MemoryAccess *access) {
+    if (_bandwidth == 0) return 1;
+    cycle_type size = get_packet_size(access);
+    return MAX((size + _bandwidth - 1) / _bandwidth, (cycle_type)1);
+}
+
+// 0 if a request is waiting to be moved, otherwise the cycles until the first in-flight
+// request arrives or the first in-buffer head can take its link.
+cycle_type SimpleInterconnect::cycles_to_next_event() {
+    for (auto &out_buffer : _out_buffers) {
+        if (!out_buffer.empty()) return 0;
+    }
+    for (uint32_t ch = 0; ch < _config.dram_channels; ch++) {
+        if (has_memreq1(ch) || has_memreq2(ch)) return 0;
+    }
+    cycle_type next_cycle = std::numeric_limits<cycle_type>::max();
+    for (auto &link : _links) {
+        if (!link.in_flight.empty()) next_cycle = MIN(next_cycle, link.in_flight.front().first);
+    }
+    for (auto &in_buffer : _in_buffers) {
+        if (in_buffer.empty()) continue;
+        auto &entity = in_buffer.front();
+        next_cycle = MIN(next_cycle, MAX(entity.finish_cycle, _links[entity.dest].free_cycle));
+    }
+    if (next_cycle == std::numeric_limits<cycle_type>::max()) return next_cycle;
+    return next_cycle > _cycles ? next_cycle - _cycles : 0;
+}
+
+void SimpleInterconnect::skip_cycles(cycle_type cycles) {
+    for (cycle_type i = 0; i < cycles; i++) {
+        update_stat_interval();
+        _cycles++;
+    }
+}
+
+bool SimpleInterconnect::idle() {
+    for (auto &in_buffer : _in_buffers) {
+        if (!in_buffer.empty()) return false;
+    }
+    for (auto &link : _links) {
+        if (!link.in_flight.empty()) return false;
+    }
+    for (auto &out_buffer : _out_buffers) {
+        if (!out_buffer.empty()) return false;
+    }
+    for (uint32_t ch = 0; ch < _config.dram_channels; ch++) {
+        if (has_memreq1(ch) || has_memreq2(ch)) return false;
+    }
+    return true;
+}
+
+// only the current stat window of each channel is kept (stats are not logged)
+void SimpleInterconnect::save_state(json &j) {
+    ast(idle());
+    j["cycles"] = _cycles;
+    save_ingress_state(j["ingress"]);
+    j["stats"] = json::array();
+    for (auto &stats : _stats) {
+        auto &stat = stats.back();
+        j["stats"].push_back(
+            {stat.start_cycle, stat.memory_reads, stat.memory_writes, stat.pim_reads});
+    }
+    j["links"] = json::array();
+    for (auto &link : _links) {
+        j["links"].push_back({link.free_cycle, link.rr_next, link.packets, link.bytes,
+                              link.busy_cycles, link.queueing_cycles});
+    }
+}
+
+void SimpleInterconnect::load_state(const json &j) {
+    ast(idle());
+    _cycles = j["cycles"];
+    load_ingress_state(j["ingress"]);
+    ast(j["stats"].size() == _stats.size());
+    for (size_t ch = 0; ch < _stats.size(); ++ch) {
+        auto &stat = j["stats"][ch];
+        _stats[ch].clear();
+        _stats[ch].push_back(MemoryIOStat(stat[0], ch, _mem_cycle_interval));
+        _stats[ch].back().memory_reads = stat[1];
+        _stats[ch].back().memory_writes = stat[2];
+        _stats[ch].back().pim_reads = stat[3];
+    }
+    ast(j["links"].size() == _links.size());
+    for (size_t dest = 0; dest < _links.size(); ++dest) {
+        auto &link = j["links"][dest];
+        _links[dest].free_cycle = link[0];
+        _links[dest].rr_next = link[1];
+        _links[dest].packets = link[2];
+        _links[dest].bytes = link[3];
+        _links[dest].busy_cycles = link[4];
+        _links[dest].queueing_cycles = link[5];
+    }
+}
+
 void SimpleInterconnect::push(uint32_t src, uint32_t dest, MemoryAccess *request) {
     // -- initialize entity
     SimpleInterconnect::Entity entity;
@@ -134,13 +448,12 @@ void SimpleInterconnect::push(uint32_t src, uint32_t dest, MemoryAccess *request
 
     // -- push to _in_buffer
     _in_buffers[src].push(entity);
+    record_push(request);
 }
 
 bool SimpleInterconnect::is_full(uint32_t nid, MemoryAccess *request) {
-    // TODO: limit buffersize
-    return false;
+    return _buffer_size > 0 && _in_buffers[nid].size() >= _buffer_size;
 }
-
 bool SimpleInterconnect::is_empty(uint32_t nid) {
     assert(nid < _dram_offset);
     return _out_buffers[nid].empty();
@@ -161,29 +474,128 @@ void SimpleInterconnect::pop(uint32_t nid) {
 
     _out_buffers[nid].pop();
 }
-// below 3 method is used to send "Memory request" to "Dram" in "Interconnect"
-// - has_memreq
-// - memreq_top
-// - memreq_pop
 
-bool SimpleInterconnect::has_memreq1(uint32_t cid) { return !_mem_req_queue1[cid].empty(); }
-bool SimpleInterconnect::has_memreq2(uint32_t cid) { return !_mem_req_queue2[cid].empty(); }
+// per-link (destination node) traffic, utilization and queueing delay
+void SimpleInterconnect::print_stats() {
+    print_latency_stats();
+    print_ingress_stats();
+    if (_cycles == 0) return;
 
-MemoryAccess *SimpleInterconnect::memreq_top1(uint32_t cid) {
-    assert(has_memreq1(cid));
-    return _mem_req_queue1[cid].front();
+    std::string fname = Config::global_config.log_dir + "/_icnt.tsv";
+    std::ofstream ofile(fname);
+    if (!ofile.is_open()) {
+        assert(0);
+    }
+    ofile << "node\tpackets\tbytes\tutilization\tavg_queueing_cycles\n";
+    uint64_t packets = 0, queueing_cycles = 0;
+    double max_utilization = 0;
+    for (uint32_t dest = 0; dest < _n_nodes; dest++) {
+        auto &link = _links[dest];
+        double utilization = (double)link.busy_cycles / _cycles;
+        ofile << dest << "\t" << link.packets << "\t" << link.bytes << "\t" << utilization
+              << "\t" << (link.packets ? (double)link.queueing_cycles / link.packets : 0)
+              << "\n";
+        packets += link.packets;
+        queueing_cycles += link.queueing_cycles;
+        max_utilization = MAX(max_utilization, utilization);
+    }
+    ofile.close();
+    if (packets == 0) return;
+    spdlog::info("Interconnect links : max utilization {:.2f}%, avg queueing delay {:.2f} cycles",
+                 max_utilization * 100, (double)queueing_cycles / packets);
 }
-MemoryAccess *SimpleInterconnect::memreq_top2(uint32_t cid) {
-    assert(has_memreq2(cid));
-    return _mem_req_queue2[cid].front();
+
+Booksim2Interconnect::Booksim2Interconnect(SimulationConfig config) {
+    _cycles = 0;
+    _config = config;
+    // same node ids as SimpleInterconnect: core_id * dram_channels + ch for cores,
+    // then one node per dram channel
+    _n_nodes = config.num_cores * config.dram_channels + config.dram_channels;
+    _dram_offset = config.num_cores * config.dram_channels;
+    _config_path = config.icnt_config_path;
+    spdlog::info("Initialize Booksim2Interconnect ({} nodes, {})", _n_nodes, _config_path);
+    if (!fs::exists(_config_path)) {
+        spdlog::error("Can't find booksim2 config {}", _config_path);
+        exit(-1);
+    }
+    _booksim = std::make_unique<booksim2::Interconnect>(_config_path, _n_nodes);
+
+    _mem_req_queue1.resize(config.dram_channels);  // for SA
+    _mem_req_queue2.resize(config.dram_channels);  // for PIM
+    _ingress.resize(config.dram_channels);
+
+    _mem_cycle_interval = 250;
+    _stats.resize(config.dram_channels);
+    for (size_t i = 0; i < config.dram_channels; ++i) {
+        _stats[i].push_back(MemoryIOStat(0, i, _mem_cycle_interval));
+    }
 }
 
-void SimpleInterconnect::memreq_pop1(uint32_t cid) {
-    assert(has_memreq1(cid));
-    _mem_req_queue1[cid].pop();
+bool Booksim2Interconnect::running() { return _booksim->busy(); }
+
+void Booksim2Interconnect::cycle() {
+    _booksim->run();
+    _cycles++;
+
+    // dram nodes -> SA / PIM request queues of the channel
+    for (uint32_t mem_ch = 0; mem_ch < _config.dram_channels; mem_ch++) {
+        uint32_t nid = _dram_offset + mem_ch;
+        while (!_booksim->is_empty(nid, 0)) {
+            auto mem_req = (MemoryAccess *)_booksim->top(nid, 0);
+            _booksim->pop(nid, 0);
+            record_delivery(mem_req);
+            push_memreq(mem_ch, mem_req);
+        }
+    }
+
+    update_stat_interval();
 }
 
-void SimpleInterconnect::memreq_pop2(uint32_t cid) {
-    assert(has_memreq2(cid));
-    _mem_req_queue2[cid].pop();
+void Booksim2Interconnect::push(uint32_t src, uint32_t dest, MemoryAccess *request) {
+    booksim2::Interconnect::Type type = get_booksim_type(request);
+    uint32_t size = get_packet_size(request);
+    record_push(request);
+    _booksim->push(request, 0, 0, size, type, src, dest);
+}
+
+bool Booksim2Interconnect::is_full(uint32_t nid, MemoryAccess *request) {
+    uint32_t size = get_packet_size(request);
+    return _booksim->is_full(nid, 0, size);
+}
+
+bool Booksim2Interconnect::is_empty(uint32_t nid) {
+    assert(nid < _dram_offset);
+    return _booksim->is_empty(nid, 0);
+}
+
+MemoryAccess *Booksim2Interconnect::top(uint32_t nid) {
+    assert(!is_empty(nid));
+    return (MemoryAccess *)_booksim->top(nid, 0);
+}
+
+void Booksim2Interconnect::pop(uint32_t nid) {
+    assert(!is_empty(nid));
+    auto mem_access = top(nid);
+    record_delivery(mem_access);
+
+    // -- collect log
+    update_stat(*mem_access, nid % _config.dram_channels);
+
+    _booksim->pop(nid, 0);
+}
+
+void Booksim2Interconnect::print_stats() {
+    _booksim->print_stats();
+    print_latency_stats();
+    print_ingress_stats();
+}
+
+booksim2::Interconnect::Type Booksim2Interconnect::get_booksim_type(MemoryAccess *access) {
+    bool write = access->req_type == MemoryAccessType::WRITE ||
+                 access->req_type == MemoryAccessType::GWRITE;
+    if (write)
+        return access->request ? booksim2::Interconnect::Type::WRITE
+                               : booksim2::Interconnect::Type::WRITE_REPLY;
+    return access->request ? booksim2::Interconnect::Type::READ
+                           : booksim2::Interconnect::Type::READ_REPLY;
 }
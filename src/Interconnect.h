@@ -5,6 +5,7 @@
 #include "Common.h"
 #include "Logger.h"
 #include "Stat.h"
+#include "StatRegistry.h"
 #include "booksim2/Interconnect.hpp"
 #include "helper/HelperFunctions.h"
 
@@ -19,12 +20,32 @@ class Interconnect {
     virtual void pop(uint32_t nid) = 0;
     virtual void print_stats() = 0;
 
-    virtual bool has_memreq1(uint32_t cid) = 0;
-    virtual bool has_memreq2(uint32_t cid) = 0;
-    virtual MemoryAccess *memreq_top1(uint32_t cid) = 0;
-    virtual MemoryAccess *memreq_top2(uint32_t cid) = 0;
-    virtual void memreq_pop1(uint32_t cid) = 0;
-    virtual void memreq_pop2(uint32_t cid) = 0;
+    // requests arrived at dram channel cid, SA (1) / PIM (2) sub-batch
+    virtual bool has_memreq1(uint32_t cid);
+    virtual bool has_memreq2(uint32_t cid);
+    virtual MemoryAccess *memreq_top1(uint32_t cid);
+    virtual MemoryAccess *memreq_top2(uint32_t cid);
+    virtual void memreq_pop1(uint32_t cid);
+    virtual void memreq_pop2(uint32_t cid);
+    bool has_memreq(uint32_t cid, uint32_t sub_batch);
+    MemoryAccess *memreq_top(uint32_t cid, uint32_t sub_batch);
+    void memreq_pop(uint32_t cid, uint32_t sub_batch);
+
+    // dram ingress arbitration (dram_ingress). memreq_order fills the sub-batches eligible
+    // for channel cid this cycle, highest priority first, and returns their count.
+    // memreq_arbitrated records which of them were tried against the dram and which it
+    // accepted. A waiting sub-batch that was not tried (arbiter or grant cap) is held.
+    uint32_t memreq_order(uint32_t cid, uint32_t order[2]);
+    void memreq_arbitrated(uint32_t cid, const bool tried[2], const bool granted[2]);
+
+    // event-driven clock skipping (in icnt cycles). default: never skip.
+    virtual cycle_type cycles_to_next_event() { return 0; }
+    virtual void skip_cycles(cycle_type /*cycles*/) {}
+
+    // checkpoint at a stage boundary. default: not supported (never idle).
+    virtual bool idle() { return false; }
+    virtual void save_state(json &/*j*/) {}
+    virtual void load_state(const json &/*j*/) {}
 
     void log(Stage stage);
     void update_stat(MemoryAccess mem_access, uint64_t ch_idx);
@@ -40,6 +61,37 @@ class Interconnect {
     // this variable is the unit of memory io request counts in core cycles
     // if it is 50, the number of memory io requests are merged in 50 core cycles granularity
     uint64_t _mem_cycle_interval;
+    void update_stat_interval();
+
+    // memory request queue of each dram channel
+    std::vector<std::queue<MemoryAccess *>> _mem_req_queue1;  // for SA
+    std::vector<std::queue<MemoryAccess *>> _mem_req_queue2;  // for PIM
+    void push_memreq(uint32_t mem_ch, MemoryAccess *mem_req);
+
+    // network latency (push -> delivered) in icnt cycles, to compare backends
+    StatRegistry::Histogram &_latency_stat = StatRegistry::GetInstance()->histogram("icnt", "latency");
+    void record_push(MemoryAccess *access) { access->icnt_enter_cycle = _cycles; }
+    void record_delivery(MemoryAccess *access);
+    void print_latency_stats();
+
+    // ingress state and stall counters of each dram channel, per sub-batch
+    struct Ingress {
+        uint32_t turn = 1;    // wrr / pim_batch: sub-batch being served
+        uint32_t served = 0;  // grants in this turn
+        uint64_t grants[2] = {0, 0};
+        uint64_t held_cycles[2] = {0, 0};  // waiting, not tried this cycle
+        uint64_t full_cycles[2] = {0, 0};  // waiting, tried but the dram was full
+        uint64_t stall_run[2] = {0, 0};
+        uint64_t max_stall[2] = {0, 0};  // longest run of stalled cycles
+    };
+    std::vector<Ingress> _ingress;
+    void print_ingress_stats();
+    void save_ingress_state(json &j);
+    void load_ingress_state(const json &j);
+
+    // data travels with write requests and read replies, the others carry control only
+    uint32_t _ctrl_size = 8;
+    uint32_t get_packet_size(MemoryAccess *access);
 };
 
 // Simple without conflict interconnect
@@ -53,20 +105,19 @@ class SimpleInterconnect : public Interconnect {
     virtual bool is_empty(uint32_t nid) override;
     virtual MemoryAccess *top(uint32_t nid) override;
     virtual void pop(uint32_t nid) override;
-    virtual void print_stats() override {}
+    virtual void print_stats() override;
 
-    virtual bool has_memreq1(uint32_t cid) override;
-    virtual bool has_memreq2(uint32_t cid) override;
-    virtual MemoryAccess *memreq_top1(uint32_t cid) override;
-    virtual MemoryAccess *memreq_top2(uint32_t cid) override;
-    virtual void memreq_pop1(uint32_t cid) override;
-    virtual void memreq_pop2(uint32_t cid) override;
+    virtual cycle_type cycles_to_next_event() override;
+    virtual void skip_cycles(cycle_type cycles) override;
+
+    virtual bool idle() override;
+    virtual void save_state(json &j) override;
+    virtual void load_state(const json &j) override;
 
    private:
     uint32_t _latency;
-    double _bandwidth;
-    uint32_t _rr_start;
-    uint32_t _buffer_size;
+    uint32_t _bandwidth;    // bytes per cycle of a link, 0: one packet per cycle
+    uint32_t _buffer_size;  // packets of an in-buffer, 0: unlimited
 
     struct Entity {
         cycle_type finish_cycle;
@@ -76,14 +127,28 @@ class SimpleInterconnect : public Interconnect {
 
     std::vector<std::queue<MemoryAccess *>> _out_buffers;  // buffer for (ICNT -> Module)
     std::vector<std::queue<Entity>> _in_buffers;           // buffer for (Module -> ICNT)
-    std::vector<bool> _busy_node;
 
-    // memory request queue
-    bool _mem_sa_q_turn;  // for checking queue1, queue2 in turn
-    std::vector<std::queue<MemoryAccess *>> _mem_req_queue1;
-    std::vector<std::queue<MemoryAccess *>> _mem_req_queue2;
+    // link into each destination node. A packet holds it for size / bandwidth cycles
+    // and arrives when it is fully sent. Sources waiting for it are served in
+    // round-robin order.
+    struct Link {
+        cycle_type free_cycle = 0;
+        uint32_t rr_next = 0;                                          // source with the highest priority
+        std::queue<std::pair<cycle_type, MemoryAccess *>> in_flight;  // (arrival cycle, packet)
+        // stats
+        uint64_t packets = 0;
+        uint64_t bytes = 0;
+        uint64_t busy_cycles = 0;
+        uint64_t queueing_cycles = 0;  // ready at the head of in-buffer -> granted
+    };
+    std::vector<Link> _links;
+    std::vector<int> _grant;  // source granted for each link in this cycle
+    cycle_type get_link_cycles(MemoryAccess *access);
+    void deliver(uint32_t dest, MemoryAccess *access);
 };
 
+// Cycle-accurate NoC (booksim2). Requests that arrive at a dram node are moved to
+// the SA / PIM request queues of the channel every cycle.
 class Booksim2Interconnect : public Interconnect {
    public:
     Booksim2Interconnect(SimulationConfig config);
@@ -97,11 +162,9 @@ class Booksim2Interconnect : public Interconnect {
     virtual void print_stats() override;
 
    private:
-    uint32_t _ctrl_size;
     std::string _config_path;
     std::unique_ptr<booksim2::Interconnect> _booksim;
 
     booksim2::Interconnect::Type get_booksim_type(MemoryAccess *access);
-    uint32_t get_packet_size(MemoryAccess *access);
 };
 #endif
\ No newline at end of file
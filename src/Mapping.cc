@@ -35,6 +35,112 @@ MappingTable from_config(SimulationConfig config) {
     return map;
 }
 
+static uint32_t ceil_div(uint32_t a, uint32_t b) { return (a + b - 1) / b; }
+
+// tile sizes of a dimension: dim split evenly into 1, 2, ... tiles, rounded up to
+// core_width so only the last tile is padded. Sizes leaving a whole empty L1 block
+// in the last tile are skipped (MatMul asserts on empty loads).
+std::vector<uint32_t> MappingSearch::tile_candidates(uint32_t dim) {
+    uint32_t width = Config::global_config.core_width;
+    uint32_t blocks = ceil_div(dim, width);
+    std::vector<uint32_t> candidates;
+    for (uint32_t outer = 1; outer <= blocks; outer++) {
+        uint32_t tile = MIN(ceil_div(blocks, outer) * width, dim);
+        if (!candidates.empty() && candidates.back() == tile) continue;
+        uint32_t last = dim - (ceil_div(dim, tile) - 1) * tile;
+        if (last <= (ceil_div(tile, width) - 1) * width) continue;
+        candidates.push_back(tile);
+    }
+    return candidates;
+}
+
+// inputs in a half of the spad, outputs in a half of the accum spad (double buffer)
+bool MappingSearch::fits(uint32_t n, uint32_t c, uint32_t m) {
+    auto &config = Config::global_config;
+    uint32_t width = config.core_width;
+    uint64_t pn = ceil_div(n, width) * width;
+    uint64_t pc = ceil_div(c, width) * width;
+    uint64_t pm = ceil_div(m, width) * width;
+    return (pn * pc + pc * pm) * config.precision <= config.spad_size KB / 2 &&
+           pn * pm * config.precision <= config.accum_spad_size KB / 2;
+}
+
+/**
+ * Modeled core cycles of a GEMM with the tile sizes, timing of NeuPIMSystolicWS:
+ *  - a tile issues one GEMM per core_width^3 block. Blocks of the stationary axis
+ *    and C are preloaded (core_height cycles), the others follow every
+ *    MAX(size, 4) cycles, plus the depth of the array
+ *  - a tile loads its inputs and stores its outputs once, at the DRAM bandwidth
+ *    shared by the cores that are busy
+ *  - tiles are spread over num_cores and double-buffered, so a tile takes the
+ *    longer of the two, and only the first load is exposed
+ */
+double MappingSearch::estimate_cycles(uint32_t batches, Mapping::LoopCounts shape,
+                                      Mapping::LoopCounts tile, bool transposed) {
+    auto &config = Config::global_config;
+    uint32_t width = config.core_width;
+    uint64_t outer_n = ceil_div(shape.N, tile.N);
+    uint64_t outer_c = ceil_div(shape.C, tile.C);
+    uint64_t outer_m = ceil_div(shape.M, tile.M);
+
+    uint64_t stationary = ceil_div(transposed ? tile.N : tile.M, width);
+    uint64_t streaming = ceil_div(transposed ? tile.M : tile.N, width);
+    uint64_t preloads = stationary * ceil_div(tile.C, width);
+    uint64_t insts = preloads * streaming;
+    uint64_t issue = MAX(width / 8, 4);
+    double compute = (insts - preloads) * issue + preloads * config.core_height +
+                     config.core_height + config.core_width - 2 + issue;
+
+    uint64_t tiles = (uint64_t)batches * outer_n * outer_c * outer_m;
+    uint64_t cores = MIN((uint64_t)config.num_cores, tiles);
+    // core_freq, dram_freq in MHz
+    double bytes_per_cycle = (double)config.dram_channels * config.dram_req_size *
+                             config.dram_freq / config.core_freq / cores;
+    double bytes = ((double)tile.N * tile.C + (double)tile.C * tile.M +
+                    (double)tile.N * tile.M / outer_c) *
+                   config.precision;
+    double load = bytes / bytes_per_cycle;
+
+    return ceil_div(tiles, cores) * MAX(compute, load) + load;
+}
+
+const Mapping &MappingSearch::search(uint32_t batches, Mapping::LoopCounts shape,
+                                     bool transposed) {
+    auto key = std::make_tuple(batches, shape.N, shape.C, shape.M, transposed);
+    auto it = _table.find(key);
+    if (it != _table.end()) return it->second;
+
+    Mapping best;
+    double best_cycles = -1;
+    for (uint32_t n : tile_candidates(shape.N)) {
+        for (uint32_t c : tile_candidates(shape.C)) {
+            for (uint32_t m : tile_candidates(shape.M)) {
+                if (!fits(n, c, m)) continue;
+                Mapping::LoopCounts tile{.N = n, .C = c, .M = m};
+                double cycles = estimate_cycles(batches, shape, tile, transposed);
+                if (best_cycles >= 0 && cycles >= best_cycles) continue;
+                best_cycles = cycles;
+                best.tile_in_loop = tile;
+            }
+        }
+    }
+    ast(best_cycles >= 0);
+
+    best.total_loop = shape;
+    best.tile_out_loop = Mapping::LoopCounts{.N = ceil_div(shape.N, best.tile_in_loop.N),
+                                             .C = ceil_div(shape.C, best.tile_in_loop.C),
+                                             .M = ceil_div(shape.M, best.tile_in_loop.M)};
+    best.tile_out_loop_order = {Mapping::LoopName::N, Mapping::LoopName::M,
+                                Mapping::LoopName::C};
+    best.spatial_M = Config::global_config.core_width;
+    best.spatial_C = Config::global_config.core_height;
+    spdlog::info("Mapping search N {} C {} M {} x{}: tile N {} C {} M {}, {:.0f} cycles",
+                 shape.N, shape.C, shape.M, batches, best.tile_in_loop.N,
+                 best.tile_in_loop.C, best.tile_in_loop.M, best_cycles);
+
+    return _table[key] = best;
+}
+
 uint32_t Mapping::LoopCounts::get_loop(Mapping::LoopName name) {
     switch (name) {
     case Mapping::LoopName::N:
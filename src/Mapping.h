@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <tuple>
 #include <vector>
 
 #include "Common.h"
@@ -66,3 +67,35 @@ struct Mapping {
 typedef std::map<Mapping::LoopCounts, Mapping> MappingTable;
 MappingTable parse_mapping_file(std::string file_path);
 MappingTable from_config(SimulationConfig config);
+
+/**
+ * MappingSearch: tile sizes of a GEMM on the systolic array (gemm_mapping: search)
+ *  A GEMM of (N, C) x (C, M) is split into tile_in_loop sized tiles, tile_out_loop
+ *  of them along each axis. Tile sizes are enumerated at core_width granularity
+ *  and must fit the double-buffered spad (inputs) and accum spad (outputs).
+ *  Each candidate is scored by estimate_cycles() and the best one is memoized
+ *  per shape, so every MatMul of the same shape reuses it.
+ *
+ *  The outer loop order stays N, M, C: partial sums of a tile stay in the accum
+ *  spad of the core, so C is innermost, and tiles do not share operands, so the
+ *  order of N and M does not change the cost.
+ */
+class MappingSearch : public Singleton<MappingSearch> {
+   private:
+    friend class Singleton;
+    MappingSearch() = default;
+    ~MappingSearch() = default;
+
+   public:
+    // batches: independent GEMMs of the shape (heads of an attention matmul)
+    // transposed: operands are swapped, M is the stationary axis of the array
+    const Mapping &search(uint32_t batches, Mapping::LoopCounts shape, bool transposed);
+
+   private:
+    std::map<std::tuple<uint32_t, uint32_t, uint32_t, uint32_t, bool>, Mapping> _table;
+
+    std::vector<uint32_t> tile_candidates(uint32_t dim);
+    bool fits(uint32_t n, uint32_t c, uint32_t m);
+    double estimate_cycles(uint32_t batches, Mapping::LoopCounts shape, Mapping::LoopCounts tile,
+                           bool transposed);
+};
@@ -19,6 +19,7 @@ std::string SoftMax = "softmax";
 std::string LsVMatMul = "LsVmm";
 std::string AReshape = "Areshape";
 std::string Residual = "res";
+std::string AllReduce = "allreduce";
 std::string Gelu = "gelu";
 std::string BatchSplit = "BSplit";
 std::string BatchConcat = "BConcat";
@@ -6,6 +6,7 @@
 #include "Tensor.h"
 #include "helper/HelperFunctions.h"
 #include "operations/Add.h"
+#include "operations/AllReduce.h"
 #include "operations/Attention.h"
 #include "operations/Concat.h"
 #include "operations/FusedMHA.h"
@@ -46,6 +47,7 @@ extern std::string SoftMax;
 extern std::string LsVMatMul;
 extern std::string AReshape;
 extern std::string Residual;
+extern std::string AllReduce;
 extern std::string Gelu;
 extern std::string BatchSplit;
 extern std::string BatchConcat;
@@ -3,33 +3,45 @@
 #include <memory>
 
 #include "Stat.h"
+#include "Tracer.h"
 #include "helper/HelperFunctions.h"
 
+static cycle_type &core_counter(uint32_t id, const std::string &name) {
+    return StatRegistry::GetInstance()->counter("core" + std::to_string(id), name);
+}
+
 NeuPIMSCore::NeuPIMSCore(uint32_t id, SimulationConfig config)
     : _id(id),
       _config(config),
       _core_cycle(0),
       _compute_end_cycle(0),
-      _stat_idle_cycle(0),
-      _stat_compute_cycle(0),
-      _stat_memory_cycle(0),
-      _stat_vec_compute_cycle(0),
-      _stat_vec_memory_cycle(0),
-      _memory_stall_cycle(0),
-      _compute_memory_stall_cycle(0),
-      _vector_memory_stall_cycle(0),
-      _layernorm_stall_cycle(0),
-      _softmax_stall_cycle(0),
-      _add_stall_cycle(0),
-      _gelu_stall_cycle(0),
-      _load_memory_cycle(0),
-      _store_memory_cycle(0),
-      _stat_vec_idle_cycle(0),
-      _stat_matmul_cycle(0),
-      _stat_layernorm_cycle(0),
-      _stat_add_cycle(0),
-      _stat_gelu_cycle(0),
-      _stat_softmax_cycle(0),
+      _stat_compute_cycle(core_counter(id, "compute_cycle")),
+      _stat_idle_cycle(core_counter(id, "idle_cycle")),
+      _stat_memory_cycle(core_counter(id, "memory_cycle")),
+      _accum_request_rr_cycle(core_counter(id, "accum_request_rr_cycle")),
+      _max_request_rr_cycle(core_counter(id, "max_request_rr_cycle")),
+      _min_request_rr_cycle(core_counter(id, "min_request_rr_cycle")),
+      _memory_stall_cycle(core_counter(id, "memory_stall_cycle")),
+      _compute_memory_stall_cycle(core_counter(id, "compute_memory_stall_cycle")),
+      _vector_memory_stall_cycle(core_counter(id, "vector_memory_stall_cycle")),
+      _layernorm_stall_cycle(core_counter(id, "layernorm_stall_cycle")),
+      _softmax_stall_cycle(core_counter(id, "softmax_stall_cycle")),
+      _add_stall_cycle(core_counter(id, "add_stall_cycle")),
+      _gelu_stall_cycle(core_counter(id, "gelu_stall_cycle")),
+      _allreduce_stall_cycle(core_counter(id, "allreduce_stall_cycle")),
+      _load_memory_cycle(core_counter(id, "load_memory_cycle")),
+      _store_memory_cycle(core_counter(id, "store_memory_cycle")),
+      _stat_vec_compute_cycle(core_counter(id, "vec_compute_cycle")),
+      _stat_vec_memory_cycle(core_counter(id, "vec_memory_cycle")),
+      _stat_vec_idle_cycle(core_counter(id, "vec_idle_cycle")),
+      _stat_matmul_cycle(core_counter(id, "matmul_cycle")),
+      _stat_layernorm_cycle(core_counter(id, "layernorm_cycle")),
+      _stat_add_cycle(core_counter(id, "add_cycle")),
+      _stat_gelu_cycle(core_counter(id, "gelu_cycle")),
+      _stat_softmax_cycle(core_counter(id, "softmax_cycle")),
+      _stat_allreduce_cycle(core_counter(id, "allreduce_cycle")),
+      _load_overlap_cycle(core_counter(id, "load_overlap_cycle")),
+      _buffer_stall_cycle(core_counter(id, "buffer_stall_cycle")),
       _spad(Sram(config, _core_cycle, false)),
       _acc_spad(Sram(config, _core_cycle, true)),
       _pim_spad(Sram(config, _core_cycle, false)),
@@ -38,20 +50,52 @@ NeuPIMSCore::NeuPIMSCore(uint32_t id, SimulationConfig config)
     _running_layer = -1;
     _current_spad = 0;
     _current_acc_spad = 0;
+    _buffer_stalled = false;
     _memory_request_queues1.resize(_config.dram_channels);
     _memory_request_queues2.resize(_config.dram_channels);
     _vector_pipelines.resize(_config.vector_core_count);
 }
 bool NeuPIMSCore::can_issue_pim() { return _pim_tiles.empty(); }
+// Double buffering (ping-pong) of SA tiles: a new tile takes the other half of
+// _spad (and of _acc_spad unless it accumulates on the current one), so its loads
+// run while the tile on the current half computes.
 // if next_tile.accum == true
 //     there is no need for _acc_spad availability
 // else
 //     need to check _acc_spad availability
+// A tile that cannot be issued marks the core as stalled on the buffer.
 bool NeuPIMSCore::can_issue(Tile &next_tile) {
+    _buffer_stalled = !can_issue_buffer(next_tile);
+    return !_buffer_stalled;
+}
+
+// An operation is named <layer>.<block>.<operation type>[...], so a dataflow
+// entry matches the full name or any of its components (e.g. "proj").
+// Operations without an entry use the dataflow of core_type.
+Dataflow NeuPIMSCore::get_dataflow(const std::string &optype) {
+    auto cached = _dataflow_of_op.find(optype);
+    if (cached != _dataflow_of_op.end()) return cached->second;
+
+    Dataflow dataflow = _config.core_type == CoreType::SYSTOLIC_OS   ? Dataflow::OS
+                        : _config.core_type == CoreType::SYSTOLIC_IS ? Dataflow::IS
+                                                                     : Dataflow::WS;
+    auto entry = _config.op_dataflow.find(optype);
+    size_t begin = 0;
+    while (entry == _config.op_dataflow.end() && begin <= optype.size()) {
+        size_t end = optype.find('.', begin);
+        if (end == std::string::npos) end = optype.size();
+        entry = _config.op_dataflow.find(optype.substr(begin, end - begin));
+        begin = end + 1;
+    }
+    if (entry != _config.op_dataflow.end()) dataflow = entry->second;
+    _dataflow_of_op[optype] = dataflow;
+    return dataflow;
+}
+
+bool NeuPIMSCore::can_issue_buffer(Tile &next_tile) {
     if (_tiles.empty()) {
         return true;
     }
-    // FIXME: disable double buffering
     auto next_spad = _current_spad ^ 1;
     auto next_acc_spad = _current_acc_spad ^ 1;
 
@@ -59,27 +103,21 @@ bool NeuPIMSCore::can_issue(Tile &next_tile) {
     for (auto tile : _tiles) {
         if (tile->spad_id == next_spad) {
             if ((tile->remaining_loads != 0) || (tile->remaining_computes != 0)) {
-                // spdlog::info("issue failed. accum true. spad id {}", tile->spad_id);
-                // std::cout << tile->remaining_loads << "\t" << tile->remaining_computes <<
-                // std::endl;
                 return false;
             }
         }
     }
     if (!next_tile.accum) {
-        // load, compute and store should be over at the other side
+        // compute should be over and the results read out by the stores at the
+        // other side. The stores may still be on the way to the dram.
         for (auto tile : _tiles) {
             if (tile->accum_spad_id == next_acc_spad) {
-                if (tile->remaining_accum_io != 0) {
-                    // spdlog::info("issue failed. accum false. acc spad id {}",
-                    // tile->accum_spad_id); std::cout << tile->remaining_accum_io << std::endl;
+                if ((tile->remaining_computes != 0) || (tile->remaining_stores != 0)) {
                     return false;
                 }
             }
         }
     }
-    // spdlog::info("issue succeeded. accum {}, spad id {}, acc spad id {}",
-    //              next_tile.accum ? "true" : "false", next_spad, next_acc_spad);
     return true;
 }
 
@@ -89,6 +127,7 @@ void NeuPIMSCore::issue(Tile &in_tile) {
     spdlog::info("tile issued {}", in_tile.repr());
     auto tile = std::make_shared<Tile>(in_tile);
     tile->stat = TileStat(_core_cycle);
+    _buffer_stalled = false;
     if (tile->skip) {
         tile->status = Tile::Status::FINISH;
         _finished_tiles.push(tile);
@@ -105,6 +144,7 @@ void NeuPIMSCore::issue(Tile &in_tile) {
         _acc_spad.flush(_current_acc_spad);
     }
     tile->accum_spad_id = _current_acc_spad;
+    tile->dataflow = get_dataflow(tile->optype);
     tile->status = Tile::Status::RUNNING;
     if (_running_layer != tile->operation_id) {
         _running_layer = tile->operation_id;
@@ -113,8 +153,10 @@ void NeuPIMSCore::issue(Tile &in_tile) {
     tile->remaining_loads = 0;
     tile->remaining_computes = 0;
     tile->remaining_accum_io = 0;
+    tile->remaining_stores = 0;
+    tile->handle = TileTable::add(tile);
     for (auto &inst : tile->instructions) {
-        inst.parent_tile = std::weak_ptr<Tile>(tile);
+        inst.parent_tile = tile->handle;
         inst.spad_id = tile->spad_id;
         inst.accum_spad_id = tile->accum_spad_id;
         Sram *buffer;
@@ -155,12 +197,13 @@ void NeuPIMSCore::issue(Tile &in_tile) {
             }
         } else if (inst.opcode == Opcode::MOVOUT || inst.opcode == Opcode::MOVOUT_POOL) {
             tile->remaining_accum_io++;
+            tile->remaining_stores++;
             _st_inst_queue_for_sa.push(inst);
         } else {
             /* Ex inst queue */
             tile->remaining_accum_io++;
             tile->remaining_computes++;
-            _ex_inst_queue_for_sa.push(inst);
+            _ex_inst_queue_for_sa.push_back(inst);
         }
     }
     // spdlog::info("tile pushed to core._tiles {}", tile.repr());
@@ -190,9 +233,10 @@ void NeuPIMSCore::issue_pim(Tile &in_tile) {
     tile->remaining_loads = 0;
     tile->remaining_computes = 0;
     tile->remaining_accum_io = 0;
+    tile->handle = TileTable::add(tile);
     for (auto &inst : tile->instructions) {
         inst.is_pim_inst = true;
-        inst.parent_tile = std::weak_ptr<Tile>(tile);
+        inst.parent_tile = tile->handle;
         inst.spad_id = tile->spad_id;
         inst.accum_spad_id = tile->accum_spad_id;
         Sram *buffer;
@@ -248,6 +292,7 @@ Ptr<Tile> NeuPIMSCore::pop_finished_tile() {
     auto result = _finished_tiles.front();
     result->stat.end_cycle = _core_cycle;
     _finished_tiles.pop();
+    TileTable::remove(result->handle);
     return result;
 }
 
@@ -266,6 +311,7 @@ void NeuPIMSCore::cycle() {
         if ((tile->remaining_accum_io == 0) && (tile->remaining_computes == 0) &&
             (tile->remaining_loads == 0)) {
             tile->status = Tile::Status::FINISH;
+            trace_tile(*tile);
             _finished_tiles.push(tile);
             tile_it = _tiles.erase(tile_it);
         } else {
@@ -279,6 +325,7 @@ void NeuPIMSCore::cycle() {
         if ((tile->remaining_accum_io == 0) && (tile->remaining_computes == 0) &&
             (tile->remaining_loads == 0)) {
             tile->status = Tile::Status::FINISH;
+            trace_tile(*tile);
             _finished_tiles.push(tile);
             tile_it = _pim_tiles.erase(tile_it);
         } else {
@@ -300,6 +347,7 @@ bool NeuPIMSCore::running() {
     for (auto &vector_pipeline : _vector_pipelines) {
         running = running || !vector_pipeline.empty();
     }
+    running = running || !_link_pipeline.empty();
 
     int status_check_interval = 1000000;
     if (_core_cycle % status_check_interval == 0 && false) {
@@ -321,6 +369,117 @@ bool NeuPIMSCore::running() {
     return running;
 }
 
+cycle_type NeuPIMSCore::cycles_to_next_event() {
+    if (!_finished_tiles.empty()) return 0;
+    if (!_ld_inst_queue_for_sa.empty() || !_ld_inst_queue_for_pim.empty()) return 0;
+    for (uint32_t ch = 0; ch < _config.dram_channels; ch++) {
+        if (has_memory_request1(ch) || has_memory_request2(ch)) return 0;
+    }
+    for (auto &tiles : {&_tiles, &_pim_tiles}) {
+        for (auto &tile : *tiles) {
+            if ((tile->remaining_accum_io == 0) && (tile->remaining_computes == 0) &&
+                (tile->remaining_loads == 0))
+                return 0;
+        }
+    }
+
+    // store waits for accum spad, compute waits for spad
+    if (!_st_inst_queue_for_sa.empty()) {
+        Instruction &front = _st_inst_queue_for_sa.front();
+        if (front.dest_addr >= ACCUM_SPAD_BASE
+                ? _acc_spad.check_hit(front.dest_addr, front.accum_spad_id)
+                : _spad.check_hit(front.dest_addr, front.spad_id))
+            return 0;
+    }
+    if (!_st_inst_queue_for_pim.empty()) {
+        Instruction &front = _st_inst_queue_for_pim.front();
+        if (front.dest_addr >= ACCUM_SPAD_BASE
+                ? _pim_acc_spad.check_hit(front.dest_addr, front.accum_spad_id)
+                : _pim_spad.check_hit(front.dest_addr, front.spad_id))
+            return 0;
+    }
+    uint32_t window = MIN((size_t)_config.ex_issue_window, _ex_inst_queue_for_sa.size());
+    for (uint32_t i = 0; i < window; i++) {
+        if (can_issue_compute(_ex_inst_queue_for_sa[i])) return 0;
+    }
+    if (!_ex_inst_queue_for_pim.empty() && pim_can_issue_compute(_ex_inst_queue_for_pim.front()))
+        return 0;
+
+    cycle_type next_cycle = std::numeric_limits<cycle_type>::max();
+    if (!_compute_pipeline.empty())
+        next_cycle = MIN(next_cycle, _compute_pipeline.front().finish_cycle);
+    for (auto &vector_pipeline : _vector_pipelines) {
+        if (!vector_pipeline.empty())
+            next_cycle = MIN(next_cycle, vector_pipeline.front().finish_cycle);
+    }
+    if (!_link_pipeline.empty())
+        next_cycle = MIN(next_cycle, _link_pipeline.front().finish_cycle);
+    if (next_cycle == std::numeric_limits<cycle_type>::max()) return next_cycle;
+    return next_cycle > _core_cycle ? next_cycle - _core_cycle : 0;
+}
+
+void NeuPIMSCore::skip_cycles(cycle_type cycles) { _core_cycle += cycles; }
+
+bool NeuPIMSCore::idle() {
+    if (running() || !_pim_tiles.empty() || !_finished_tiles.empty()) return false;
+    if (!_ld_inst_queue_for_pim.empty() || !_st_inst_queue_for_pim.empty() ||
+        !_ex_inst_queue_for_pim.empty())
+        return false;
+    for (uint32_t ch = 0; ch < _config.dram_channels; ch++) {
+        if (has_memory_request1(ch) || has_memory_request2(ch)) return false;
+    }
+    return _memory_request_queue.empty() && _memory_response_queue.empty();
+}
+
+void NeuPIMSCore::save_state(json &j) {
+    ast(idle());
+    j["core_cycle"] = _core_cycle;
+    j["compute_end_cycle"] = _compute_end_cycle;
+    j["running_layer"] = _running_layer;
+    j["current_spad"] = _current_spad;
+    j["current_acc_spad"] = _current_acc_spad;
+    j["stats"] = {_stat_compute_cycle,        _stat_idle_cycle,
+                  _stat_memory_cycle,         _accum_request_rr_cycle,
+                  _max_request_rr_cycle,      _min_request_rr_cycle,
+                  _memory_stall_cycle,        _compute_memory_stall_cycle,
+                  _vector_memory_stall_cycle, _layernorm_stall_cycle,
+                  _softmax_stall_cycle,       _add_stall_cycle,
+                  _gelu_stall_cycle,          _load_memory_cycle,
+                  _store_memory_cycle,        _stat_vec_compute_cycle,
+                  _stat_vec_memory_cycle,     _stat_vec_idle_cycle,
+                  _stat_matmul_cycle,         _stat_layernorm_cycle,
+                  _stat_add_cycle,            _stat_gelu_cycle,
+                  _stat_softmax_cycle,        _stat_allreduce_cycle,
+                  _allreduce_stall_cycle,     _load_overlap_cycle,
+                  _buffer_stall_cycle};
+}
+
+void NeuPIMSCore::load_state(const json &j) {
+    ast(idle());
+    _core_cycle = j["core_cycle"];
+    _compute_end_cycle = j["compute_end_cycle"];
+    _running_layer = j["running_layer"];
+    _current_spad = j["current_spad"];
+    _current_acc_spad = j["current_acc_spad"];
+    std::vector<cycle_type *> stats = {
+        &_stat_compute_cycle,        &_stat_idle_cycle,
+        &_stat_memory_cycle,         &_accum_request_rr_cycle,
+        &_max_request_rr_cycle,      &_min_request_rr_cycle,
+        &_memory_stall_cycle,        &_compute_memory_stall_cycle,
+        &_vector_memory_stall_cycle, &_layernorm_stall_cycle,
+        &_softmax_stall_cycle,       &_add_stall_cycle,
+        &_gelu_stall_cycle,          &_load_memory_cycle,
+        &_store_memory_cycle,        &_stat_vec_compute_cycle,
+        &_stat_vec_memory_cycle,     &_stat_vec_idle_cycle,
+        &_stat_matmul_cycle,         &_stat_layernorm_cycle,
+        &_stat_add_cycle,            &_stat_gelu_cycle,
+        &_stat_softmax_cycle,        &_stat_allreduce_cycle,
+        &_allreduce_stall_cycle,     &_load_overlap_cycle,
+        &_buffer_stall_cycle};
+    ast(j["stats"].size() == stats.size());
+    for (size_t i = 0; i < stats.size(); i++) *stats[i] = j["stats"][i];
+}
+
 // push into target channel memory request queue
 void NeuPIMSCore::push_memory_request1(MemoryAccess *request) {
     int channel = AddressConfig::mask_channel(request->dram_address);
@@ -338,7 +497,7 @@ void NeuPIMSCore::push_memory_response(MemoryAccess *response) {
     Sram *acc_spad = &_acc_spad;
     Sram *spad = &_spad;
     uint32_t buf_id;
-    if (auto parent = response->parent_tile.lock()) {
+    if (auto parent = response->parent_tile.get()) {
         if (parent->stage_platform == StagePlatform::PIM) {
             spad = &_pim_spad;
             acc_spad = &_pim_acc_spad;
@@ -347,7 +506,7 @@ void NeuPIMSCore::push_memory_response(MemoryAccess *response) {
 
     bool is_write = response->req_type == MemoryAccessType::WRITE;
     bool is_read = response->req_type == MemoryAccessType::READ;
-    if (auto tile = response->parent_tile.lock()) {
+    if (auto tile = response->parent_tile.get()) {
         if (is_write) {
             tile->remaining_accum_io--;
         } else {
@@ -384,7 +543,7 @@ void NeuPIMSCore::pim_push_memory_response(MemoryAccess *response) {
 
     bool is_write = response->req_type == MemoryAccessType::WRITE;
     bool is_read = response->req_type == MemoryAccessType::READ;
-    if (auto tile = response->parent_tile.lock()) {
+    if (auto tile = response->parent_tile.get()) {
         if (is_write) {
             tile->remaining_accum_io--;
         } else {
@@ -472,12 +631,19 @@ void NeuPIMSCore::print_stats() {
         _id, _compute_memory_stall_cycle, _layernorm_stall_cycle, _softmax_stall_cycle,
         _add_stall_cycle, _gelu_stall_cycle);
 
+    if (_config.n_tp > 1 && _config.tp_allreduce != AllReduceAlgo::NONE)
+        spdlog::info("NeuPIMSCore [{}] : AllReduce cycle {} AllReduce stall cycle {}", _id,
+                     _stat_allreduce_cycle, _allreduce_stall_cycle);
     spdlog::info(
         "NeuPIMSCore [{}] : Load stall cycle {} Store stall cycle {} "
         "Total memory stall {} Idle cycle {}",
         _id, _load_memory_cycle, _store_memory_cycle,
 
         _stat_memory_cycle, _stat_idle_cycle);
+    spdlog::info(
+        "NeuPIMSCore [{}] : Load overlapped with compute {} cycles, Tile issue stalled on "
+        "double buffer {} cycles",
+        _id, _load_overlap_cycle, _buffer_stall_cycle);
     // spdlog::info(
     //     "NeuPIMSCore [{}] : Compute cycle {} Memory Stall Cycle {} Idle Cycle {}",
     //     _id, _stat_compute_cycle, _stat_memory_cycle, _stat_idle_cycle);
@@ -489,4 +655,22 @@ void NeuPIMSCore::print_stats() {
     spdlog::info("NeuPIMSCore [{}] : Total cycle: {}", _id, _core_cycle);
 }
 
-void NeuPIMSCore::log() {}
\ No newline at end of file
+void NeuPIMSCore::log() {}
+
+// tile lifetime (issue -> finish) on the track of its sub-batch
+void NeuPIMSCore::trace_tile(Tile &tile) {
+    if (!_config.trace) return;
+    uint32_t tid =
+        tile.stage_platform == StagePlatform::SA ? TRACE_TID_SA_TILE : TRACE_TID_PIM_TILE;
+    Tracer::GetInstance()->complete(TRACE_PID_CORE + _id, tid, tile.optype,
+                                    Tracer::core_us(tile.stat.start_cycle),
+                                    Tracer::core_us(_core_cycle - tile.stat.start_cycle));
+}
+
+// instruction in the systolic (tid TRACE_TID_SYSTOLIC) or a vector pipeline
+void NeuPIMSCore::trace_inst(Instruction &inst, uint32_t tid) {
+    if (!_config.trace) return;
+    Tracer::GetInstance()->complete(TRACE_PID_CORE + _id, tid, opcodeTypeString(inst.opcode),
+                                    Tracer::core_us(inst.start_cycle),
+                                    Tracer::core_us(inst.finish_cycle - inst.start_cycle));
+}
\ No newline at end of file
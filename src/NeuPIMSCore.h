@@ -1,6 +1,7 @@
 #pragma once
 
 #include <list>
+#include <map>
 #include <memory>
 #include <vector>
 
@@ -8,6 +9,7 @@
 #include "SimulationConfig.h"
 #include "Sram.h"
 #include "Stat.h"
+#include "StatRegistry.h"
 
 class NeuPIMSCore {
    public:
@@ -25,6 +27,20 @@ class NeuPIMSCore {
 
     virtual void cycle();
 
+    // event-driven clock skipping
+    // - cycles_to_next_event: 0 if this core can change its state in this cycle,
+    //   otherwise the cycles until the first instruction in pipelines finishes
+    // - skip_cycles: advance idle cycles at once (stats are updated as if cycle() was called)
+    virtual cycle_type cycles_to_next_event();
+    virtual void skip_cycles(cycle_type cycles);
+
+    // checkpoint at a stage boundary
+    // - idle: no tile, instruction or memory access is left in this core
+    // - save_state/load_state: cycle counter, spad turns and stats
+    virtual bool idle();
+    virtual void save_state(json &j);
+    virtual void load_state(const json &j);
+
     // add index to each methods
     virtual bool has_memory_request1(uint32_t index) {
         return _memory_request_queues1[index].size() > 0;
@@ -57,39 +73,55 @@ class NeuPIMSCore {
    protected:
     virtual bool can_issue_compute(Instruction &inst);
     virtual bool pim_can_issue_compute(Instruction &inst);
+    bool can_issue_buffer(Tile &next_tile);
     virtual cycle_type get_inst_compute_cycles(Instruction &inst) = 0;
+    void trace_tile(Tile &tile);
+    void trace_inst(Instruction &inst, uint32_t tid);
+    Dataflow get_dataflow(const std::string &optype);
 
     const uint32_t _id;
     const SimulationConfig _config;
 
     cycle_type _core_cycle;
     uint64_t _compute_end_cycle;
-    cycle_type _stat_compute_cycle;
-    cycle_type _stat_idle_cycle;
-    cycle_type _stat_memory_cycle;
-    cycle_type _accum_request_rr_cycle;
-    cycle_type _max_request_rr_cycle;
-    cycle_type _min_request_rr_cycle;
-    cycle_type _memory_stall_cycle;
-    cycle_type _compute_memory_stall_cycle;
-    cycle_type _vector_memory_stall_cycle;
-    cycle_type _layernorm_stall_cycle;
-    cycle_type _softmax_stall_cycle;
-    cycle_type _add_stall_cycle;
-    cycle_type _gelu_stall_cycle;
-    cycle_type _load_memory_cycle;
-    cycle_type _store_memory_cycle;
+    // stats below are counters of the StatRegistry, scope "core<id>"
+    cycle_type &_stat_compute_cycle;
+    cycle_type &_stat_idle_cycle;
+    cycle_type &_stat_memory_cycle;
+    cycle_type &_accum_request_rr_cycle;
+    cycle_type &_max_request_rr_cycle;
+    cycle_type &_min_request_rr_cycle;
+    cycle_type &_memory_stall_cycle;
+    cycle_type &_compute_memory_stall_cycle;
+    cycle_type &_vector_memory_stall_cycle;
+    cycle_type &_layernorm_stall_cycle;
+    cycle_type &_softmax_stall_cycle;
+    cycle_type &_add_stall_cycle;
+    cycle_type &_gelu_stall_cycle;
+    cycle_type &_allreduce_stall_cycle;
+    cycle_type &_load_memory_cycle;
+    cycle_type &_store_memory_cycle;
 
     /* Vector Unit Params */
-    cycle_type _stat_vec_compute_cycle;
-    cycle_type _stat_vec_memory_cycle;  // Does not acctuall count yet
-    cycle_type _stat_vec_idle_cycle;    // Does not acctuall count yet
-
-    cycle_type _stat_matmul_cycle;
-    cycle_type _stat_layernorm_cycle;
-    cycle_type _stat_add_cycle;
-    cycle_type _stat_gelu_cycle;
-    cycle_type _stat_softmax_cycle;
+    cycle_type &_stat_vec_compute_cycle;
+    cycle_type &_stat_vec_memory_cycle;  // Does not acctuall count yet
+    cycle_type &_stat_vec_idle_cycle;    // Does not acctuall count yet
+
+    cycle_type &_stat_matmul_cycle;
+    cycle_type &_stat_layernorm_cycle;
+    cycle_type &_stat_add_cycle;
+    cycle_type &_stat_gelu_cycle;
+    cycle_type &_stat_softmax_cycle;
+    cycle_type &_stat_allreduce_cycle;
+
+    // double buffering: loads in flight while the systolic array computes, and
+    // cycles a tile waits at issue for the other half of the spads
+    cycle_type &_load_overlap_cycle;
+    cycle_type &_buffer_stall_cycle;
+    bool _buffer_stalled;
+
+    // systolic dataflow of each operation name, resolved once
+    std::map<std::string, Dataflow> _dataflow_of_op;
 
     int _running_layer;
     std::deque<std::shared_ptr<Tile>> _tiles;
@@ -98,11 +130,13 @@ class NeuPIMSCore {
 
     std::queue<Instruction> _compute_pipeline;
     std::vector<std::queue<Instruction>> _vector_pipelines;
+    // all-reduces in flight on the inter-device link (tp_allreduce)
+    std::queue<Instruction> _link_pipeline;
 
     // SA Sub-batch queue
     std::queue<Instruction> _ld_inst_queue_for_sa;
     std::queue<Instruction> _st_inst_queue_for_sa;
-    std::queue<Instruction> _ex_inst_queue_for_sa;
+    std::deque<Instruction> _ex_inst_queue_for_sa;  // dispatched out of order, see ex_queue_cycle
 
     // PIM Sub-batch queue
     std::queue<Instruction> _ld_inst_queue_for_pim;
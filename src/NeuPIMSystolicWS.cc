@@ -1,6 +1,15 @@
 #include "NeuPIMSystolicWS.h"
 
-NeuPIMSystolicWS::NeuPIMSystolicWS(uint32_t id, SimulationConfig config) : NeuPIMSCore(id, config) {
+NeuPIMSystolicWS::NeuPIMSystolicWS(uint32_t id, SimulationConfig config)
+    : NeuPIMSCore(id, config),
+      _stat_systolic_inst_issue_count(StatRegistry::GetInstance()->counter(
+          "core" + std::to_string(id), "systolic_inst_issue_count")),
+      _stat_systolic_preload_issue_count(StatRegistry::GetInstance()->counter(
+          "core" + std::to_string(id), "systolic_preload_issue_count")),
+      _stat_systolic_spad_read_bytes(StatRegistry::GetInstance()->counter(
+          "core" + std::to_string(id), "systolic_spad_read_bytes")),
+      _stat_systolic_fill_drain_cycles(StatRegistry::GetInstance()->counter(
+          "core" + std::to_string(id), "systolic_fill_drain_cycles")) {
     auto stat = NPUStat(_core_cycle);
     _stat.push_back(stat);
 }
@@ -10,6 +19,32 @@ void NeuPIMSystolicWS::log() {
     Logger::log(_stat, fname);
 }
 
+void NeuPIMSystolicWS::save_state(json& j) {
+    NeuPIMSCore::save_state(j);
+    j["systolic_inst_issue_count"] = _stat_systolic_inst_issue_count;
+    j["systolic_preload_issue_count"] = _stat_systolic_preload_issue_count;
+    j["systolic_spad_read_bytes"] = _stat_systolic_spad_read_bytes;
+    j["systolic_fill_drain_cycles"] = _stat_systolic_fill_drain_cycles;
+    j["utilization"] = json::array();
+    for (auto& stat : _stat)
+        j["utilization"].push_back({stat.start_cycle, stat.num_cycles, stat.num_calculations});
+}
+
+void NeuPIMSystolicWS::load_state(const json& j) {
+    NeuPIMSCore::load_state(j);
+    _stat_systolic_inst_issue_count = j["systolic_inst_issue_count"];
+    _stat_systolic_preload_issue_count = j["systolic_preload_issue_count"];
+    // not in checkpoints taken before the dataflow stats
+    _stat_systolic_spad_read_bytes = j.value("systolic_spad_read_bytes", (uint64_t)0);
+    _stat_systolic_fill_drain_cycles = j.value("systolic_fill_drain_cycles", (uint64_t)0);
+    _stat.clear();
+    for (auto& stat : j["utilization"]) {
+        _stat.push_back(NPUStat(stat[0].get<uint64_t>()));
+        _stat.back().num_cycles = stat[1];
+        _stat.back().num_calculations = stat[2];
+    }
+}
+
 void NeuPIMSystolicWS::cycle() {
     if (_stat.back().start_cycle + 1000 < _core_cycle) {
         auto stat = NPUStat(_core_cycle);
@@ -18,6 +53,7 @@ void NeuPIMSystolicWS::cycle() {
     // compute in SA, VU
     systolic_cycle();
     vector_unit_cycle();
+    link_cycle();
 
     // instruction fetch
     ld_queue_cycle();
@@ -34,6 +70,21 @@ void NeuPIMSystolicWS::cycle() {
     NeuPIMSCore::cycle();
 }
 
+void NeuPIMSystolicWS::skip_cycles(cycle_type cycles) {
+    // nothing is issued or retired while skipping, so per-cycle stats are accumulated in bulk.
+    // split at NPUStat window boundaries to keep the same utilization log as cycle().
+    while (cycles > 0) {
+        if (_stat.back().start_cycle + 1000 < _core_cycle) {
+            auto stat = NPUStat(_core_cycle);
+            _stat.push_back(stat);
+        }
+        cycle_type span = MIN(_stat.back().start_cycle + 1001 - _core_cycle, cycles);
+        update_stats(span);
+        NeuPIMSCore::skip_cycles(span);
+        cycles -= span;
+    }
+}
+
 void NeuPIMSystolicWS::systolic_cycle() {
     /* Compute unit */
     if (!_compute_pipeline.empty() && _compute_pipeline.front().finish_cycle <= _core_cycle) {
@@ -45,12 +96,13 @@ void NeuPIMSystolicWS::systolic_cycle() {
         } else {
             assert(0);
         }
-        if (auto tile = inst.parent_tile.lock()) {
+        if (auto tile = inst.parent_tile.get()) {
             tile->remaining_accum_io--;
             tile->remaining_computes--;
         } else {
             assert(0);
         }
+        trace_inst(inst, TRACE_TID_SYSTOLIC);
         _compute_pipeline.pop();
         // spdlog::info("cycle: {}, pop {}", _core_cycle, inst.repr());
     }
@@ -67,7 +119,8 @@ void NeuPIMSystolicWS::vector_unit_cycle() {
     */
     // vector pipeline needs iterating vectors
     // todo: vector_unit.cycle();
-    for (auto &vector_pipeline : _vector_pipelines) {
+    for (uint32_t i = 0; i < _vector_pipelines.size(); i++) {
+        auto &vector_pipeline = _vector_pipelines[i];
         if (!vector_pipeline.empty() && vector_pipeline.front().finish_cycle <= _core_cycle) {
             Instruction &inst = vector_pipeline.front();
             Sram *buffer = inst.is_pim_inst ? &_pim_acc_spad : &_acc_spad;
@@ -76,17 +129,33 @@ void NeuPIMSystolicWS::vector_unit_cycle() {
             } else {
                 assert(0);
             }
-            if (auto tile = inst.parent_tile.lock()) {
+            if (auto tile = inst.parent_tile.get()) {
                 tile->remaining_accum_io--;
                 tile->remaining_computes--;
             } else {
                 assert(0);
             }
+            trace_inst(inst, TRACE_TID_VECTOR + i);
             vector_pipeline.pop();
         }
     }
 }
 
+void NeuPIMSystolicWS::link_cycle() {
+    if (!_link_pipeline.empty() && _link_pipeline.front().finish_cycle <= _core_cycle) {
+        Instruction &inst = _link_pipeline.front();
+        _acc_spad.fill(inst.dest_addr, inst.accum_spad_id);
+        if (auto tile = inst.parent_tile.get()) {
+            tile->remaining_accum_io--;
+            tile->remaining_computes--;
+        } else {
+            assert(0);
+        }
+        trace_inst(inst, TRACE_TID_LINK);
+        _link_pipeline.pop();
+    }
+}
+
 void NeuPIMSystolicWS::ld_queue_cycle() {
     /* LD instruction queue */
     // todo: ld_queue.cycle();
@@ -115,7 +184,7 @@ void NeuPIMSystolicWS::ld_queue_cycle() {
 
             // xxx is this right? size, count<<src_addrs size
             buffer->reserve(front.dest_addr, buffer_id, front.size, accesses.size());
-            if (auto tile = front.parent_tile.lock()) {
+            if (auto tile = front.parent_tile.get()) {
                 tile->remaining_loads += accesses.size() - 1;
                 tile->stat.memory_reads += accesses.size() * AddressConfig::alignment;
             } else {
@@ -215,8 +284,9 @@ void NeuPIMSystolicWS::st_queue_cycle() {
             auto accesses = MemoryAccess::from_instruction(
                 front, generate_mem_access_id(), _config.dram_req_size, MemoryAccessType::WRITE,
                 true, _id, _core_cycle, buffer_id, StagePlatform::SA);
-            if (auto tile = front.parent_tile.lock()) {
+            if (auto tile = front.parent_tile.get()) {
                 tile->remaining_accum_io += accesses.size() - 1;
+                tile->remaining_stores--;
                 tile->stat.memory_writes += accesses.size() * AddressConfig::alignment;
             } else {
                 assert(0);
@@ -250,7 +320,7 @@ void NeuPIMSystolicWS::pim_st_queue_cycle() {
             auto accesses = MemoryAccess::from_instruction(
                 front, generate_mem_access_id(), _config.dram_req_size, MemoryAccessType::WRITE,
                 true, _id, _core_cycle, buffer_id, StagePlatform::PIM);
-            if (auto tile = front.parent_tile.lock()) {
+            if (auto tile = front.parent_tile.get()) {
                 tile->remaining_accum_io += accesses.size() - 1;
                 tile->stat.memory_writes += accesses.size() * AddressConfig::alignment;
             } else {
@@ -265,19 +335,60 @@ void NeuPIMSystolicWS::pim_st_queue_cycle() {
     }
 }
 
+// Out-of-order dispatch: up to ex_issue_width instructions whose operands are
+// loaded are picked from the oldest ex_issue_window ones in the queue per cycle,
+// so the vector pipelines are filled while an older instruction waits for loads.
 void NeuPIMSystolicWS::ex_queue_cycle() {
     /* EX instruction queue */
-    if (!_ex_inst_queue_for_sa.empty()) {
-        Instruction ready_inst = get_first_ready_ex_inst();
-
-        if (ready_inst.valid)
-            issue_ex_inst(ready_inst);
-        else {
+    uint32_t issued = 0;
+    uint32_t window = MIN((size_t)_config.ex_issue_window, _ex_inst_queue_for_sa.size());
+    for (uint32_t i = 0; i < window && issued < _config.ex_issue_width;) {
+        if (!can_issue_compute(_ex_inst_queue_for_sa[i]) || has_ex_hazard(i)) {
             /* Update memory stall stat */
+            i++;
+            continue;
         }
+        Instruction ready_inst = _ex_inst_queue_for_sa[i];
+        _ex_inst_queue_for_sa.erase(_ex_inst_queue_for_sa.begin() + i);
+        window--;
+        issue_ex_inst(ready_inst);
+        issued++;
     }
 }
 
+// an instruction may not pass an older one in the queue that it depends on:
+//  - systolic instructions share the array (and a preload chain), so stay in order
+//  - instructions on the same accumulator buffer stay in order. Instruction::size is
+//    not a byte extent for every opcode (GEMM carries loop_size / 8, some vector ops 0),
+//    so their accumulator footprints can not be compared and any pair may be RAW/WAR/WAW
+bool NeuPIMSystolicWS::has_ex_hazard(uint32_t index) {
+    Instruction &inst = _ex_inst_queue_for_sa[index];
+    bool systolic = inst.opcode == Opcode::GEMM || inst.opcode == Opcode::GEMM_PRELOAD;
+    for (uint32_t i = 0; i < index; i++) {
+        Instruction &older = _ex_inst_queue_for_sa[i];
+        if (systolic && (older.opcode == Opcode::GEMM || older.opcode == Opcode::GEMM_PRELOAD))
+            return true;
+        if (older.accum_spad_id == inst.accum_spad_id) return true;
+    }
+    return false;
+}
+
+// vector pipeline that is free first, and the cycle an instruction pushed to it starts
+std::queue<Instruction> *NeuPIMSystolicWS::next_vector_pipeline(cycle_type &start_cycle) {
+    std::queue<Instruction> *least_filled_vpu = nullptr;
+    start_cycle = std::numeric_limits<cycle_type>::max();
+    for (auto &vector_pipeline : _vector_pipelines) {
+        cycle_type free_cycle =
+            vector_pipeline.empty() ? _core_cycle : MAX(vector_pipeline.back().finish_cycle,
+                                                         _core_cycle);
+        if (free_cycle < start_cycle) {
+            least_filled_vpu = &vector_pipeline;
+            start_cycle = free_cycle;
+        }
+    }
+    return least_filled_vpu;
+}
+
 void NeuPIMSystolicWS::pim_ex_queue_cycle() {
     /* EX instruction queue */
     if (!_ex_inst_queue_for_pim.empty()) {
@@ -296,87 +407,150 @@ void NeuPIMSystolicWS::pim_ex_queue_cycle() {
     }
 }
 
-void NeuPIMSystolicWS::update_stats() {
+void NeuPIMSystolicWS::update_stats(cycle_type cycles) {
     if (!_compute_pipeline.empty()) {
-        auto parent_tile = _compute_pipeline.front().parent_tile.lock();
+        auto parent_tile = _compute_pipeline.front().parent_tile.get();
         if (parent_tile == nullptr) {
             assert(0);
         }
-        parent_tile->stat.compute_cycles++;
-        _stat.back().num_calculations += 128 * 8 * 2;  // apply systolic array count
+        parent_tile->stat.compute_cycles += cycles;
+        _stat.back().num_calculations += 128 * 8 * 2 * cycles;  // apply systolic array count
     }
     for (auto &vector_pipeline : _vector_pipelines) {
         if (!vector_pipeline.empty()) {
-            auto parent_tile = vector_pipeline.front().parent_tile.lock();
+            auto parent_tile = vector_pipeline.front().parent_tile.get();
             if (parent_tile == nullptr) {
                 assert(0);
             }
-            parent_tile->stat.compute_cycles++;
-            _stat.back().num_calculations += 16;  // apply systolic array count
+            parent_tile->stat.compute_cycles += cycles;
+            _stat.back().num_calculations += 16 * cycles;  // apply systolic array count
         }
     }
+    if (!_link_pipeline.empty()) {
+        _link_pipeline.front().parent_tile.get()->stat.compute_cycles += cycles;
+    }
 
-    // xxx will it work well on double buffered code? no.
-    bool is_idle = _compute_pipeline.empty();
+    // With double buffering the next tile loads while the current one computes, so
+    // a memory stall is counted only while nothing computes: waiting for the
+    // operands of the next instruction (load) or, with nothing left to compute, for
+    // the results to be written back (store). A core with neither is idle.
+    bool is_idle = _compute_pipeline.empty() && _link_pipeline.empty();
     for (auto &vector_pipeline : _vector_pipelines) {
         is_idle = is_idle && vector_pipeline.empty();
     }
-    if (is_idle) {
-        _stat_memory_cycle++;
+    bool loading = !_ld_inst_queue_for_sa.empty();
+    bool storing = !_st_inst_queue_for_sa.empty();
+    for (auto &tile : _tiles) {
+        loading = loading || tile->remaining_loads != 0;
+        storing = storing || tile->remaining_accum_io != 0;
+    }
+    if (_buffer_stalled) _buffer_stall_cycle += cycles;
+    if (!is_idle && loading) _load_overlap_cycle += cycles;
 
-        if (_ex_inst_queue_for_sa.empty()) {
-            _store_memory_cycle++;
-        } else {
-            _load_memory_cycle++;
+    if (is_idle) {
+        if (!_ex_inst_queue_for_sa.empty()) {
+            _stat_memory_cycle += cycles;
+            _load_memory_cycle += cycles;
             switch (_ex_inst_queue_for_sa.front().opcode) {
                 case Opcode::GEMM:
                 case Opcode::GEMM_PRELOAD:
-                    _compute_memory_stall_cycle++;
+                    _compute_memory_stall_cycle += cycles;
                     break;
                 case Opcode::LAYERNORM:
-                    _layernorm_stall_cycle++;
+                    _layernorm_stall_cycle += cycles;
                     break;
                 case Opcode::SOFTMAX:
-                    _softmax_stall_cycle++;
+                    _softmax_stall_cycle += cycles;
                     break;
                 case Opcode::ADD:
-                    _add_stall_cycle++;
+                    _add_stall_cycle += cycles;
                     break;
                 case Opcode::GELU:
-                    _gelu_stall_cycle++;
+                    _gelu_stall_cycle += cycles;
+                    break;
+                case Opcode::ALLREDUCE:
+                    _allreduce_stall_cycle += cycles;
                     break;
             }
+        } else if (storing) {
+            _stat_memory_cycle += cycles;
+            _store_memory_cycle += cycles;
         }
     } else if (!_compute_pipeline.empty()) {
-        _stat_matmul_cycle++;
+        _stat_matmul_cycle += cycles;
     } else {
         // } else if (!_vector_pipeline.empty()) {
         // when element in vector pipeline
         for (auto &vector_pipeline : _vector_pipelines) {
+            if (vector_pipeline.empty()) continue;
             switch (vector_pipeline.front().opcode) {
                 case Opcode::LAYERNORM:
-                    _stat_layernorm_cycle++;
+                    _stat_layernorm_cycle += cycles;
                     break;
                 case Opcode::SOFTMAX:
-                    _stat_softmax_cycle++;
+                    _stat_softmax_cycle += cycles;
                     break;
                 case Opcode::ADD:
-                    _stat_add_cycle++;
+                    _stat_add_cycle += cycles;
                     break;
                 case Opcode::GELU:
-                    _stat_gelu_cycle++;
+                    _stat_gelu_cycle += cycles;
+                    break;
+                case Opcode::ALLREDUCE:  // on _link_pipeline, counted below
                     break;
             }
         }
+        if (!_link_pipeline.empty()) _stat_allreduce_cycle += cycles;
     }
 
     if (!running()) {
-        _stat_idle_cycle++;
+        _stat_idle_cycle += cycles;
     }
 }
 
+// Fill of the array (height + width - 2) and the streamed operand. An OS
+// instruction also drains its outputs, one PE row per cycle.
 cycle_type NeuPIMSystolicWS::get_inst_compute_cycles(Instruction &inst) {
-    return _config.core_height + _config.core_width - 2 + MAX(inst.size, 4);
+    cycle_type cycles = _config.core_height + _config.core_width - 2 + get_stream_cycles(inst);
+    if (inst.parent_tile.get()->dataflow == Dataflow::OS) cycles += _config.core_height;
+    return cycles;
+}
+
+// Cycles the streamed operand enters the array, at the rate of inst.size
+// (MatMul sets it to the L1 tile size / 8):
+//  WS: activation rows, OS: the reduced dimension (tile_k),
+//  IS: weight columns (tile_n)
+cycle_type NeuPIMSystolicWS::get_stream_cycles(Instruction &inst) {
+    switch (inst.parent_tile.get()->dataflow) {
+        case Dataflow::OS:
+            return MAX((inst.tile_k + 7) / 8, 4);
+        case Dataflow::IS:
+            return MAX((inst.tile_n + 7) / 8, 4);
+        default:
+            return MAX(inst.size, 4);
+    }
+}
+
+// WS keeps a weight tile for the L1 tiles of the same K, N (GEMM_PRELOAD),
+// IS loads the activation tile of every instruction and OS loads nothing.
+bool NeuPIMSystolicWS::has_preload(Instruction &inst, Dataflow dataflow) {
+    switch (dataflow) {
+        case Dataflow::OS:
+            return false;
+        case Dataflow::IS:
+            return true;
+        default:
+            return inst.opcode == Opcode::GEMM_PRELOAD;
+    }
+}
+
+// elements read from the spad into the array: the streamed operand, and the
+// stationary one when it is preloaded (OS streams both)
+uint64_t NeuPIMSystolicWS::get_spad_read_size(Instruction &inst, Dataflow dataflow) {
+    uint64_t activation = (uint64_t)inst.tile_m * inst.tile_k;
+    uint64_t weight = (uint64_t)inst.tile_k * inst.tile_n;
+    if (dataflow == Dataflow::WS && !has_preload(inst, dataflow)) return activation;
+    return activation + weight;
 }
 
 cycle_type NeuPIMSystolicWS::get_vector_compute_cycles(Instruction &inst) {
@@ -402,12 +576,43 @@ cycle_type NeuPIMSystolicWS::get_vector_compute_cycles(Instruction &inst) {
             return vec_op_iter * _config.gelu_latency;
         case Opcode::DUMMY:
             return 1;
+        case Opcode::ALLREDUCE:
+            // runs on the tp link, see get_allreduce_cycles
+            return 0;
     }
-    spdlog::info("not configured operation. {}", inst.id);
+    spdlog::info("not configured operation. {}", opcodeTypeString(inst.opcode));
     // assert(0);
     return 0;
 }
 
+// Link model of the all-reduce of inst.size elements over n_tp devices. Each
+// step sends one message over the inter-device link (latency + size/bandwidth)
+// and the received partial sums are added on the vector unit.
+//  ring: reduce-scatter + all-gather, 2(n-1) steps of size/n, n-1 reductions
+//  tree: reduce + broadcast, 2*log2(n) steps of size, log2(n) reductions
+cycle_type NeuPIMSystolicWS::get_allreduce_cycles(Instruction &inst) {
+    uint32_t n = _config.n_tp;
+    if (n == 1) return 0;
+
+    // core_freq is in MHz
+    double bytes_per_cycle = _config.tp_link_bandwidth * 1e3 / _config.core_freq;
+    cycle_type latency = std::ceil(_config.tp_link_latency * _config.core_freq / 1e3);
+
+    uint32_t msg_size, steps, reductions;
+    if (_config.tp_allreduce == AllReduceAlgo::TREE) {
+        msg_size = inst.size;
+        reductions = std::ceil(std::log2(n));
+        steps = 2 * reductions;
+    } else {
+        msg_size = (inst.size + n - 1) / n;
+        reductions = n - 1;
+        steps = 2 * reductions;
+    }
+    cycle_type transfer = std::ceil(msg_size * _config.precision / bytes_per_cycle);
+    cycle_type reduce = calculate_vector_op_iterations(msg_size) * _config.add_latency;
+    return steps * (latency + transfer) + reductions * reduce;
+}
+
 cycle_type NeuPIMSystolicWS::calculate_add_tree_iterations(uint32_t vector_size) {
     uint32_t calculation_unit = _config.vector_core_width;
     if (vector_size <= calculation_unit) {
@@ -424,61 +629,72 @@ cycle_type NeuPIMSystolicWS::calculate_add_tree_iterations(uint32_t vector_size)
 void NeuPIMSystolicWS::issue_ex_inst(Instruction inst) {
     // spdlog::info("cycle:{}, {}", _core_cycle, inst.repr());
     if (inst.opcode == Opcode::GEMM || inst.opcode == Opcode::GEMM_PRELOAD) {
-        auto parent_tile = inst.parent_tile.lock();
+        auto parent_tile = inst.parent_tile.get();
         if (parent_tile == nullptr) {
             assert(0);
         }
         // spdlog::info("COMPUTE Start cycle: {} inst:{}", _core_cycle, inst.repr());
         parent_tile->stat.num_calculation += inst.tile_m * inst.tile_n * inst.tile_k;
 
-        if (inst.opcode == Opcode::GEMM_PRELOAD) {
+        Dataflow dataflow = parent_tile->dataflow;
+        bool preload = has_preload(inst, dataflow);
+        if (preload) {
             _stat_systolic_preload_issue_count++;
         }
-        if (!_compute_pipeline.empty()) {
+        _stat_systolic_spad_read_bytes += get_spad_read_size(inst, dataflow) * _config.precision;
+        // the array is drained before it runs another dataflow
+        bool pipelined = !_compute_pipeline.empty() &&
+                         _compute_pipeline.back().parent_tile.get()->dataflow == dataflow;
+        if (pipelined) {
             /* Preload can be hided */
-            uint32_t offset = _compute_pipeline.back().size;
             // xxx why 4?
             // maybe pushing to the systolic array input queue. 4 cycles to start?
-            offset = MAX(offset, 4);
-            if (inst.opcode == Opcode::GEMM_PRELOAD) {
+            uint32_t offset = get_stream_cycles(_compute_pipeline.back());
+            if (preload) {
                 // State mul-pre
                 parent_tile->stat.weight_load_cycles += _config.core_height;
+                _stat_systolic_fill_drain_cycles += _config.core_height;
                 offset = _config.core_height;
+            } else if (dataflow == Dataflow::OS) {
+                // outputs of the previous instruction are still shifted out
+                offset = MAX(offset, _config.core_height);
             }
             inst.start_cycle = _compute_pipeline.back().start_cycle + offset;
         } else {
-            inst.start_cycle = _core_cycle;
-            /* Preload weight to systolic array*/
-            if (inst.opcode == Opcode::GEMM_PRELOAD) {
+            inst.start_cycle = _compute_pipeline.empty()
+                                   ? _core_cycle
+                                   : MAX(_compute_pipeline.back().finish_cycle, _core_cycle);
+            /* Preload weight (WS) or input (IS) to systolic array*/
+            if (preload) {
                 /* Weight preload  from buffer latecny + WEight preload
                  * latency */
                 inst.start_cycle += _config.core_height + _config.core_height - 1;
+                _stat_systolic_fill_drain_cycles += _config.core_height + _config.core_height - 1;
             }
         }
+        if (dataflow == Dataflow::OS) _stat_systolic_fill_drain_cycles += _config.core_height;
 
         inst.finish_cycle = inst.start_cycle + get_inst_compute_cycles(inst);
         // spdlog::info("finish_cycle: {}", inst.finish_cycle);
         _compute_pipeline.push(inst);
         _stat_systolic_inst_issue_count++;
+    } else if (inst.opcode == Opcode::ALLREDUCE) {
+        // the link is a resource of its own, so all-reduces wait only for each other and
+        // the vector pipelines stay free during the transfers. The additions of the
+        // received partial sums are counted in the all-reduce time.
+        inst.start_cycle = _link_pipeline.empty()
+                               ? _core_cycle
+                               : MAX(_link_pipeline.back().finish_cycle, _core_cycle);
+        inst.finish_cycle = inst.start_cycle + get_allreduce_cycles(inst);
+        _link_pipeline.push(inst);
     } else if (inst.opcode == Opcode::COMP || inst.opcode == Opcode::IM2COL ||
                inst.opcode == Opcode::LAYERNORM || inst.opcode == Opcode::SOFTMAX ||
                inst.opcode == Opcode::ADD || inst.opcode == Opcode::GELU ||
                inst.opcode == Opcode::DUMMY) {  // vector unit compute
         // spdlog::info("COMPUTE Start cycle: {} inst:{}", _core_cycle, inst.repr());
-        std::queue<Instruction> *least_filled_vpu;
-        cycle_type finish_cycle = std::numeric_limits<uint64_t>::max();
-        for (auto &vector_pipeline : _vector_pipelines) {
-            if (vector_pipeline.empty()) {
-                least_filled_vpu = &vector_pipeline;
-                finish_cycle = _core_cycle;
-                break;
-            }
-            if (vector_pipeline.back().finish_cycle < finish_cycle) {
-                least_filled_vpu = &vector_pipeline;
-                finish_cycle = _core_cycle;
-            }
-        }
-        inst.start_cycle = finish_cycle;
+        cycle_type start_cycle;
+        std::queue<Instruction> *least_filled_vpu = next_vector_pipeline(start_cycle);
+        inst.start_cycle = start_cycle;
         inst.finish_cycle = inst.start_cycle + get_vector_compute_cycles(inst);
         least_filled_vpu->push(inst);
 
@@ -525,6 +741,8 @@ void NeuPIMSystolicWS::print_stats() {
                  _stat_systolic_inst_issue_count);
     spdlog::info("NeuPIMSCore [{}] : Systolic PRELOAD Issue Count : {}", _id,
                  _stat_systolic_preload_issue_count);
+    spdlog::info("NeuPIMSCore [{}] : Systolic SPAD Read Bytes : {}, Fill/Drain Cycles : {}", _id,
+                 _stat_systolic_spad_read_bytes, _stat_systolic_fill_drain_cycles);
 }
 
 void NeuPIMSystolicWS::pim_issue_ex_inst(Instruction inst) {
@@ -532,7 +750,7 @@ void NeuPIMSystolicWS::pim_issue_ex_inst(Instruction inst) {
     if (inst.opcode == Opcode::GEMM || inst.opcode == Opcode::GEMM_PRELOAD) {
         // xxx: not yet for pim.
         assert(0);
-        auto parent_tile = inst.parent_tile.lock();
+        auto parent_tile = inst.parent_tile.get();
         if (parent_tile == nullptr) {
             assert(0);
         }
@@ -573,20 +791,9 @@ void NeuPIMSystolicWS::pim_issue_ex_inst(Instruction inst) {
                inst.opcode == Opcode::ADD || inst.opcode == Opcode::GELU ||
                inst.opcode == Opcode::DUMMY) {  // vector unit compute
         // spdlog::info("COMPUTE Start cycle: {} inst:{}", _core_cycle, inst.repr());
-        std::queue<Instruction> *least_filled_vpu;
-        cycle_type finish_cycle = std::numeric_limits<uint64_t>::max();
-        for (auto &vector_pipeline : _vector_pipelines) {
-            if (vector_pipeline.empty()) {
-                least_filled_vpu = &vector_pipeline;
-                finish_cycle = _core_cycle;
-                break;
-            }
-            if (vector_pipeline.back().finish_cycle < finish_cycle) {
-                least_filled_vpu = &vector_pipeline;
-                finish_cycle = _core_cycle;
-            }
-        }
-        inst.start_cycle = finish_cycle;
+        cycle_type start_cycle;
+        std::queue<Instruction> *least_filled_vpu = next_vector_pipeline(start_cycle);
+        inst.start_cycle = start_cycle;
         inst.finish_cycle = inst.start_cycle + get_vector_compute_cycles(inst);
         least_filled_vpu->push(inst);
 
@@ -616,16 +823,4 @@ void NeuPIMSystolicWS::pim_issue_ex_inst(Instruction inst) {
         //  inst.accum_spad_id, inst.size);
         _pim_acc_spad.reserve(inst.dest_addr, inst.accum_spad_id, inst.size, 1);
     }
-}
-
-// TODO: execution instruction should need to issue multiple execution instructions for multiple
-// pipelines
-Instruction NeuPIMSystolicWS::get_first_ready_ex_inst() {
-    Instruction inst = _ex_inst_queue_for_sa.front();
-    if (can_issue_compute(inst)) {
-        _ex_inst_queue_for_sa.pop();
-        return std::move(inst);
-    }
-
-    return Instruction{.valid = false};
 }
\ No newline at end of file
@@ -1,28 +1,43 @@
 #include "NeuPIMSCore.h"
+#include "Tracer.h"
 
+// Systolic array + vector units. GEMM instructions run in the dataflow of
+// their tile (Tile::dataflow): weight stationary unless core_type or the
+// dataflow entry of the operation selects output or input stationary.
 class NeuPIMSystolicWS : public NeuPIMSCore {
    public:
     NeuPIMSystolicWS(uint32_t id, SimulationConfig config);
     virtual void cycle() override;
+    virtual void skip_cycles(cycle_type cycles) override;
     virtual void print_stats() override;
     virtual void log() override;
+    virtual void save_state(json& j) override;
+    virtual void load_state(const json& j) override;
 
    protected:
     virtual cycle_type get_inst_compute_cycles(Instruction& inst) override;
-    uint32_t _stat_systolic_inst_issue_count = 0;
-    uint32_t _stat_systolic_preload_issue_count = 0;
+    uint64_t &_stat_systolic_inst_issue_count;
+    uint64_t &_stat_systolic_preload_issue_count;
+    uint64_t &_stat_systolic_spad_read_bytes;
+    uint64_t &_stat_systolic_fill_drain_cycles;
+    cycle_type get_stream_cycles(Instruction& inst);
+    bool has_preload(Instruction& inst, Dataflow dataflow);
+    uint64_t get_spad_read_size(Instruction& inst, Dataflow dataflow);
     cycle_type get_vector_compute_cycles(Instruction& inst);
+    cycle_type get_allreduce_cycles(Instruction& inst);
     cycle_type calculate_add_tree_iterations(uint32_t vector_size);
     cycle_type calculate_vector_op_iterations(uint32_t vector_size);
     void issue_ex_inst(Instruction inst);
     void pim_issue_ex_inst(Instruction inst);
-    Instruction get_first_ready_ex_inst();
+    bool has_ex_hazard(uint32_t index);
+    std::queue<Instruction> *next_vector_pipeline(cycle_type &start_cycle);
 
     std::vector<NPUStat> _stat;
 
     // NPU SA, VU cycle
     void systolic_cycle();
     void vector_unit_cycle();
+    void link_cycle();  // tp all-reduce
 
     // Queue for SA block, PIM block
     void ld_queue_cycle();
@@ -35,5 +50,5 @@ class NeuPIMSystolicWS : public NeuPIMSCore {
     void pim_ex_queue_cycle();
 
     // Update stats
-    void update_stats();
+    void update_stats(cycle_type cycles = 1);
 };
\ No newline at end of file
@@ -5,6 +5,7 @@ uint32_t answer_index;
 uint32_t row_index;
 std::vector<std::string> columns;
 std::vector<std::vector<uint32_t>> table;
+int arrival_index = -1;
 
 void init(std::string path, uint32_t _answer_index) {
     row_index = 0;
@@ -23,7 +24,14 @@ bool has_data() { return row_index < table.size(); }
 std::pair<uint32_t, uint32_t> get_qa_length() {
     ast(has_data());
     auto row = table[row_index++];
-    return std::make_pair(row[0], row[answer_index]);
+    // traces for online channel placement may have seq_len only
+    uint32_t answer = row.size() > answer_index ? row[answer_index] : UINT32_MAX;
+    return std::make_pair(row[0], answer);
+}
+
+uint32_t get_arrival_us() {
+    ast(has_data() && arrival_index >= 0);
+    return table[row_index][arrival_index];
 }
 
 void parse(std::string path) {
@@ -38,6 +46,7 @@ void parse(std::string path) {
         std::istringstream iss(line);
         std::string column_name;
         while (std::getline(iss, column_name, ',')) {
+            if (column_name == "arrival_us") arrival_index = columns.size();
             columns.push_back(column_name);
         }
     }
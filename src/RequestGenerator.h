@@ -5,10 +5,12 @@ extern uint32_t answer_index;
 extern uint32_t row_index;
 extern std::vector<std::string> columns;
 extern std::vector<std::vector<uint32_t>> table;
+extern int arrival_index;  // arrival_us column, -1 if the trace has none
 
 void init(std::string path, uint32_t _answer_index);
 bool has_data();
-std::pair<uint32_t, uint32_t> get_qa_length();
+std::pair<uint32_t, uint32_t> get_qa_length();  // UINT32_MAX if no answer column
+uint32_t get_arrival_us();  // of the next request
 int get_total_req_cnt();
 void parse(std::string path);
 }  // namespace RequestGenerator
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <map>
 #include <nlohmann/json.hpp>
 #include <string>
 
@@ -9,8 +10,15 @@ typedef uint64_t cycle_type;
 
 enum class CoreType {
   SYSTOLIC_OS,
-  SYSTOLIC_WS
-}; // 核心类型：脉动阵列 输出驻留 (OS) 或 权重驻留 (WS) 目前只实现了一种
+  SYSTOLIC_WS,
+  SYSTOLIC_IS
+}; // 核心类型：脉动阵列 输出驻留 (OS)、权重驻留 (WS) 或 输入驻留 (IS)
+
+enum class Dataflow {
+  WS, // weights preloaded, activation rows streamed
+  OS, // partial sums kept in the PEs, drained to the accum spad
+  IS  // activations preloaded, weight columns streamed
+}; // 脉动阵列数据流
 
 enum class DramType {
   DRAM,
@@ -25,6 +33,45 @@ enum class IcntType {
 
 enum class RunMode { NPU_ONLY, NPU_PIM }; // 运行模式：仅NPU 或 NPU+PIM异构
 
+enum class ArrivalMode {
+  BURST,   // every request at cycle 0
+  FIXED,   // one request per 1/qps sec
+  POISSON, // exponential inter-arrival times with mean 1/qps sec
+  TRACE    // arrival_us column of the request trace
+}; // 请求到达模式
+
+enum class TileDispatch {
+  ROUND_ROBIN,     // cores take turns
+  LEAST_LOADED,    // core with the fewest unfinished tiles
+  CHANNEL_AFFINITY // core owning the DRAM channel of the tile's first load
+}; // 多核 Tile 分发策略
+
+enum class AllReduceAlgo {
+  NONE, // single device, partial sums are not reduced
+  RING, // reduce-scatter + all-gather over a ring, 2(n-1) steps of 1/n data
+  TREE  // reduce + broadcast over a binary tree, 2*log2(n) steps of all data
+}; // 张量并行 all-reduce 算法
+
+enum class IngressPolicy {
+  PRIORITY, // ingress_priority sub-batch first
+  WRR,      // weighted round-robin of ingress_sa_weight / ingress_pim_weight
+  DEADLINE, // heads waiting over ingress_deadline first, oldest first
+  PIM_BATCH // one sub-batch at a time, up to ingress_batch requests
+}; // DRAM 入口 SA / PIM 子批仲裁策略
+
+enum class ChannelPlacement {
+  TRACE,       // ch_idx column of the request trace (placed offline)
+  ROUND_ROBIN, // next channel with enough free PIM tiles
+  MIN_LATENCY, // least accumulated MHA latency
+  CAPACITY,    // most free PIM tiles
+  LOOKAHEAD    // admission window placed longest first on the least latency
+}; // 请求的 PIM 通道放置策略
+
+enum class GemmMapping {
+  HEURISTIC, // halve the largest tile dimension until it fits the scratchpad
+  SEARCH     // tile sizes with the least modeled cycles, memoized per shape
+}; // MatMul 在脉动阵列上的分块策略
+
 struct SimulationConfig {
   // gpt model config (GPT模型配置)
   std::string model_name;    // 模型名称
@@ -38,7 +85,8 @@ struct SimulationConfig {
   /* Custom Config (自定义配置) */
   RunMode run_mode;         // NPU (运行模式)
   bool sub_batch_mode;      // 是否开启子批处理模式
-  bool ch_load_balancing;   // 是否开启通道负载均衡
+  ChannelPlacement channel_placement; // PIM channel of a new request
+                                      // (请求通道放置策略)
   bool kernel_fusion;       // 是否开启算子融合
   uint32_t max_batch_size;  // 最大批大小
   uint32_t max_active_reqs; // max size of (ready_queue + running_queue) in
@@ -47,17 +95,48 @@ struct SimulationConfig {
   uint64_t HBM_size;         // HBM size in bytes (HBM总容量，字节)
   uint64_t HBM_act_buf_size; // HBM activation buffer size in bytes
                              // (HBM激活值缓冲区大小，字节)
+  bool clock_skip;           // skip idle core/icnt cycles (event-driven clock)
+                             // (跳过空闲周期，周期数不变)
+  bool trace;                // write a Chrome trace of tiles, pipelines, PIM
+                             // bursts and stages to _trace.json (时间线追踪)
+  std::string checkpoint_dir;     // save a checkpoint at every stage boundary
+                                  // (在每个阶段边界保存检查点)
+  std::string restore_checkpoint; // resume from this checkpoint directory
+                                  // (从该检查点目录恢复运行)
+  bool fast_forward;             // extrapolate repeated C/D layers after warm-up
+                                 // (预热后外推重复的 C/D 层)
+  uint32_t fast_forward_warmup;  // C/D iterations simulated in detail at least
+  double fast_forward_tolerance; // convergence threshold of C+D cycles (ratio)
+
+  uint32_t tile_cache_size; // operations whose tiles are reused, 0 disables
+  GemmMapping gemm_mapping; // MatMul tiling on the systolic array
+  uint32_t kv_block_rows;   // DRAM rows per PIM KV cache block
+  bool continuous_batching; // OrcaScheduler: iteration-level batching
+                            // (每次迭代边界加入/移除请求)
 
   /* Core config (核心配置 - NPU脉动阵列) */
   uint32_t num_cores;   // 核心数量
-  CoreType core_type;   // 核心类型 (OS/WS)
+  TileDispatch tile_dispatch; // how tiles are spread over cores (多核分发策略)
+  CoreType core_type;   // 核心类型 (OS/WS/IS), default dataflow
+  std::map<std::string, Dataflow> op_dataflow; // dataflow of an operation
+                                               // type (按算子类型选择数据流)
   uint32_t core_freq;   // 核心频率
   uint32_t core_width;  // 脉动阵列宽度
   uint32_t core_height; // 脉动阵列高度
 
   uint32_t n_tp; // Tensor Parallelism degree (张量并行度)
+  AllReduceAlgo tp_allreduce; // all-reduce of the n_tp devices after
+                              // projection and FFN2 (设备间 all-reduce)
+  double tp_link_bandwidth;   // inter-device link bandwidth (GB/s)
+  double tp_link_latency;     // inter-device link latency per step (ns)
+  uint32_t n_pp;              // Pipeline Parallelism degree (流水线并行度)
+  double pp_link_bandwidth;   // link bandwidth between pipeline stages (GB/s)
+  double pp_link_latency;     // link latency between pipeline stages (ns)
 
   uint32_t vector_core_count; // 向量核心数量
+  uint32_t ex_issue_width;    // ex instructions dispatched per cycle (发射宽度)
+  uint32_t ex_issue_window;   // oldest ex instructions considered for
+                              // out-of-order dispatch, 1: in order (乱序窗口)
   uint32_t vector_core_width; // 向量核心宽度 (SIMD宽度)
 
   /* Vector config (向量单元配置及延迟) */
@@ -102,6 +181,12 @@ struct SimulationConfig {
   uint32_t request_input_seq_len;   // 请求输入序列长度
   uint32_t request_interval;        // 请求间隔
   uint32_t request_total_cnt;       // 总请求数量
+  uint32_t request_output_size;     // tokens generated per request (输出长度)
+  ArrivalMode request_arrival;      // 请求到达模式
+  double request_qps;               // arrival rate of fixed / poisson mode
+  uint32_t request_seed;            // seed of poisson arrivals
+  double slo_ttft_ms;               // time to first token SLO, 0 disables
+  double slo_tpot_ms;               // time per output token SLO, 0 disables
   std::string request_dataset_path; // 请求数据集路径
 
   /* ICNT config (互连网络配置) */
@@ -109,6 +194,18 @@ struct SimulationConfig {
   std::string icnt_config_path; // 互连配置文件路径
   uint32_t icnt_freq;           // 互连频率
   uint32_t icnt_latency;        // 互连延迟
+  uint32_t icnt_bandwidth;      // bytes per icnt cycle of a link, 0: one
+                                // packet per cycle (链路带宽)
+  uint32_t icnt_buffer_size;    // packets in the in-buffer of a node, 0:
+                                // unlimited (输入缓冲区容量)
+  IngressPolicy dram_ingress;   // SA / PIM arbitration at each dram channel
+                                // (DRAM 入口仲裁)
+  uint32_t ingress_priority;    // 1: SA, 2: PIM sub-batch first
+  uint32_t ingress_sa_weight;   // wrr grants of SA per turn
+  uint32_t ingress_pim_weight;  // wrr grants of PIM per turn
+  cycle_type ingress_deadline;  // icnt cycles since the push into the icnt
+  uint32_t ingress_batch;       // grants of a sub-batch before switching
+  uint32_t ingress_grants;      // requests a channel accepts per icnt cycle
 
   /* Sheduler config (调度器配置) */
   std::string scheduler_type; // 调度器类型
@@ -4,14 +4,19 @@
 #include <string>
 
 #include "NeuPIMSystolicWS.h"
+#include "StatRegistry.h"
+#include "Tracer.h"
 #include "SystolicOS.h"
 #include "SystolicWS.h"
+#include "allocator/AddressAllocator.h"
+#include "operations/TileCache.h"
 #include "scheduler/NeuPIMScheduler.h"
 #include "scheduler/OrcaScheduler.h"
 
 namespace fs = std::filesystem;
 
-Simulator::Simulator(SimulationConfig config) : _config(config), _core_cycles(0) {
+Simulator::Simulator(SimulationConfig config)
+    : _config(config), _core_cycles(0), _checkpoint_taken(false) {
     // Create dram object
     _core_period = 1.0 / ((double)config.core_freq);
     _icnt_period = 1.0 / ((double)config.icnt_freq);
@@ -27,22 +32,24 @@ Simulator::Simulator(SimulationConfig config) : _config(config), _core_cycles(0)
     _dram = std::make_unique<PIM>(config); //_dram 是一个 PIM类型的指针。也即DRAM类型的
 
     // Create interconnect object
-    _icnt = std::make_unique<SimpleInterconnect>(config);
-    // if (config.icnt_type == IcntType::SIMPLE) {
-    // } else if (config.icnt_type == IcntType::BOOKSIM2) {
-    //     _icnt = std::make_unique<Booksim2Interconnect>(config);
-    // } else {
-    //     assert(0);
-    // }    // 目前的模拟器只支持简单的互连网络模型，虽然代码里留有 BookSim2 ，但注释掉了
+    if (config.icnt_type == IcntType::SIMPLE) {
+        _icnt = std::make_unique<SimpleInterconnect>(config);
+    } else if (config.icnt_type == IcntType::BOOKSIM2) {
+        config.icnt_config_path =
+            fs::path(__FILE__).parent_path().append(config.icnt_config_path).string();
+        _icnt = std::make_unique<Booksim2Interconnect>(config);
+    } else {
+        assert(0);
+    }
 
 
 
     // Create core objects
     _cores.resize(config.num_cores);
-    _n_cores = config.num_cores; // 只有1个核
+    _n_cores = config.num_cores; // 脉动阵列核心数量
     _n_memories = config.dram_channels; //32通道
     for (int core_index = 0; core_index < _n_cores; core_index++) {
-        spdlog::info("initializing NeuPIM SystolicWS cores.");
+        spdlog::info("initializing NeuPIM Systolic cores.");
         _cores[core_index] = std::make_unique<NeuPIMSystolicWS>(core_index, _config);
     }
 
@@ -65,12 +72,43 @@ void Simulator::run(std::string model_name) {
     spdlog::info("======Start Simulation=====");
     _scheduler->launch(_model);
     spdlog::info("assign model {}", model_name);
+    if (!_config.restore_checkpoint.empty()) load_checkpoint(_config.restore_checkpoint);
+    if (_config.trace) open_trace();
     cycle();
 }
 
+void Simulator::open_trace() {
+    auto tracer = Tracer::GetInstance();
+    tracer->open(Config::global_config.log_dir + "/_trace.json");
+    tracer->name_process(TRACE_PID_SCHEDULER, "Scheduler");
+    tracer->name_track(TRACE_PID_SCHEDULER, TRACE_TID_STAGE, "Stage");
+    tracer->name_track(TRACE_PID_SCHEDULER, TRACE_TID_OPERATION, "Operations");
+    tracer->name_process(TRACE_PID_DRAM, "DRAM");
+    for (int ch = 0; ch < _n_memories; ch++)
+        tracer->name_track(TRACE_PID_DRAM, ch, "CH " + std::to_string(ch) + " PIM");
+    for (int core_id = 0; core_id < _n_cores; core_id++) {
+        uint32_t pid = TRACE_PID_CORE + core_id;
+        tracer->name_process(pid, "Core " + std::to_string(core_id));
+        tracer->name_track(pid, TRACE_TID_SA_TILE, "SA tiles");
+        tracer->name_track(pid, TRACE_TID_PIM_TILE, "PIM tiles");
+        tracer->name_track(pid, TRACE_TID_SYSTOLIC, "Systolic");
+        if (_config.n_tp > 1 && _config.tp_allreduce != AllReduceAlgo::NONE)
+            tracer->name_track(pid, TRACE_TID_LINK, "TP link");
+        for (uint32_t i = 0; i < _config.vector_core_count; i++)
+            tracer->name_track(pid, TRACE_TID_VECTOR + i, "Vector " + std::to_string(i));
+    }
+}
+
 void Simulator::update_stage_stat() {
     Stage done_stage = _scheduler->get_prev_stage();
     _dram->log(done_stage);
+    if (_config.trace) {
+        cycle_type start_cycle = _stage_stats.empty() ? 0 : _stage_stats.back().done_cycle;
+        Tracer::GetInstance()->complete(TRACE_PID_SCHEDULER, TRACE_TID_STAGE,
+                                        stageToString(done_stage), Tracer::core_us(start_cycle),
+                                        Tracer::core_us(_core_cycles - start_cycle));
+    }
+    KVCacheAlloc::GetInstance()->record_usage(_core_cycles);
 
     _stage_stats.push_back(StageStat{.stage = done_stage,
                                      .done_cycle = _core_cycles,
@@ -109,6 +147,37 @@ void Simulator::log_stage_stat() {
         ofile << stage_row + "\n";
     }
 
+    // fast-forward: the skipped decoder layers are extrapolated from the mean of
+    // the last two simulated C/D iterations
+    uint32_t ff_layers = _scheduler->get_fast_forward_layers();
+    if (ff_layers > 0) {
+        uint64_t projected_cycle = prev_cycle;
+        for (Stage stage : {Stage::C, Stage::D}) {
+            double cycles = 0, pim_cycles = 0, mem_bw_util = 0;
+            int cnt = 0;
+            for (int i = _stage_stats.size() - 1; i > 0 && cnt < 2; i--) {
+                if (_stage_stats[i].stage != stage) continue;
+                cycles += _stage_stats[i].done_cycle - _stage_stats[i - 1].done_cycle;
+                pim_cycles += _stage_stats[i].pim_cycles;
+                mem_bw_util += _stage_stats[i].mem_bw_util;
+                cnt++;
+            }
+            assert(cnt > 0);
+            uint64_t total_cycle = std::llround(cycles / cnt * ff_layers);
+            projected_cycle += total_cycle;
+
+            std::string stage_row = "";
+            stage_row += stageToString(stage) + "(ff x" + std::to_string(ff_layers) + ")\t";
+            stage_row += std::to_string(total_cycle) + "\t";
+            stage_row += std::to_string(std::llround(pim_cycles / cnt * ff_layers)) + "\t";
+            stage_row += std::to_string(mem_bw_util / cnt) + "\t";
+            ofile << stage_row + "\n";
+        }
+        spdlog::info("Fast-forward: {} C/D iterations simulated, {} extrapolated, "
+                     "projected total {} cycles",
+                     _scheduler->get_simulated_layers(), ff_layers, projected_cycle);
+    }
+
     ofile.close();
 }
 
@@ -216,7 +285,7 @@ void Simulator::cycle() {
         if (_cycle_mask & ICNT_MASK) { 
             for (int core_id = 0; core_id < _n_cores; core_id++) {
                 for (uint32_t channel_index = 0; channel_index < _n_memories; ++channel_index) {
-                    auto core_ind = core_id * _n_cores + channel_index;
+                    auto core_ind = core_id * _n_memories + channel_index;
                     // core -> ICNT (sub-batch #1)
                     if (_cores[core_id]->has_memory_request1(channel_index)) {
                         MemoryAccess *front = _cores[core_id]->top_memory_request1(channel_index);
@@ -246,25 +315,25 @@ void Simulator::cycle() {
             for (int dram_ind = 0; dram_ind < _n_memories; dram_ind++) {
                 auto mem_ind = _n_cores * _n_memories + dram_ind;
 
-                // ICNT to memory (log write)
-
-                // (Sub-batch#1 -> DRAM)
-                if (_icnt->has_memreq1(dram_ind)) {
-                    auto memreq_sa = _icnt->memreq_top1(dram_ind);
-                    if (!_dram->is_full(dram_ind, memreq_sa)) {
-                        _dram->push(dram_ind, memreq_sa);
-                        _icnt->memreq_pop1(dram_ind);
-                    }
-                }
-
-                // (Sub-batch#2 -> DRAM) // only for NeuPIMs
-                if (_icnt->has_memreq2(dram_ind)) {
-                    auto memreq_sa = _icnt->memreq_top2(dram_ind);
-                    if (!_dram->is_full(dram_ind, memreq_sa)) {
-                        _dram->push(dram_ind, memreq_sa);
-                        _icnt->memreq_pop2(dram_ind);
+                // ICNT to memory (log write). The ingress arbiter decides which of the
+                // sub-batch #1 (SA) / #2 (PIM, only for NeuPIMs) queues push this cycle,
+                // up to ingress_grants of them. The next one is tried if the dram is full.
+                uint32_t order[2];
+                bool tried[2] = {false, false};
+                bool granted[2] = {false, false};
+                uint32_t n_offered = _icnt->memreq_order(dram_ind, order);
+                uint32_t n_granted = 0;
+                for (uint32_t i = 0; i < n_offered && n_granted < _config.ingress_grants; i++) {
+                    auto memreq = _icnt->memreq_top(dram_ind, order[i]);
+                    tried[order[i] - 1] = true;
+                    if (!_dram->is_full(dram_ind, memreq)) {
+                        _dram->push(dram_ind, memreq);
+                        _icnt->memreq_pop(dram_ind, order[i]);
+                        granted[order[i] - 1] = true;
+                        n_granted++;
                     }
                 }
+                _icnt->memreq_arbitrated(dram_ind, tried, granted);
 
                 // Pop response to ICNT from dram (log read)
                 if (!_dram->is_empty(dram_ind) && !_icnt->is_full(mem_ind, _dram->top(dram_ind))) {
@@ -275,6 +344,16 @@ void Simulator::cycle() {
 
             _icnt->cycle();
         }
+
+        // the stage boundary lasts until the next core cycle starts the next stage
+        if (!_scheduler->has_stage_changed()) {
+            _checkpoint_taken = false;
+        } else if (!_checkpoint_taken && !_config.checkpoint_dir.empty()) {
+            save_checkpoint();
+            _checkpoint_taken = true;
+        }
+
+        if (_config.clock_skip) skip_idle_cycles();
     }
     spdlog::info("Simulation Finished");
     /* Print simulation stats */
@@ -282,11 +361,18 @@ void Simulator::cycle() {
         _cores[core_id]->print_stats();
         _cores[core_id]->log();
     }
-    // _icnt->print_stats();
+    _icnt->print_stats();
     // _icnt->log();
     _dram->print_stat();
     _scheduler->print_stat();
     log_stage_stat();
+    _client->print_stat();
+    KVCacheAlloc::GetInstance()->print_stat();
+    if (_config.tile_cache_size > 0)
+        spdlog::info("Tile cache: {} hits, {} misses", TileCache::GetInstance()->get_hits(),
+                     TileCache::GetInstance()->get_misses());
+    StatRegistry::GetInstance()->dump(Config::global_config.log_dir + "/_stats.json");
+    Tracer::GetInstance()->close();
 }
 
 void Simulator::launch_model(Ptr<Model> model) { _model = model; }
@@ -331,6 +417,164 @@ void Simulator::set_cycle_mask() {
     }
 }
 
+// Event-driven clock skipping.
+// When the client, scheduler, cores and interconnect are all waiting for a future event, their
+// cycles are advanced at once instead of polling them every cycle. DRAM keeps being ticked every
+// dram cycle (refresh and bank timing change by themselves), and skipping stops as soon as a
+// response is ready, so the simulated cycles are the same as the lockstep loop.
+void Simulator::skip_idle_cycles() {
+    if (!running()) return;
+
+    // cores are not ticked when there is no program to run. see cycle()
+    bool core_ticks = !(_scheduler->empty1() && _scheduler->empty2());
+    cycle_type core_window =
+        MIN(_client->cycles_to_next_event(), _scheduler->cycles_to_next_event());
+    for (int core_id = 0; core_id < _n_cores; core_id++) {
+        core_window = MIN(core_window, _cores[core_id]->cycles_to_next_event());
+        if (!_scheduler->empty1()) {
+            Tile &tile = _scheduler->top_tile1(core_id);
+            if (tile.status == Tile::Status::INITIALIZED && _cores[core_id]->can_issue(tile))
+                return;
+        }
+        if (!_scheduler->empty2()) {
+            Tile &tile = _scheduler->top_tile2(core_id);
+            if (tile.status == Tile::Status::INITIALIZED && _cores[core_id]->can_issue_pim())
+                return;
+        }
+    }
+    cycle_type icnt_window = _icnt->cycles_to_next_event();
+    if (core_window == 0 || icnt_window == 0 || _dram->cycles_to_next_event() == 0) return;
+
+    cycle_type core_skipped = 0;
+    cycle_type icnt_skipped = 0;
+    while (true) {
+        double core_time = _core_time;
+        double dram_time = _dram_time;
+        double icnt_time = _icnt_time;
+        set_cycle_mask();
+        if (((_cycle_mask & CORE_MASK) && core_skipped == core_window) ||
+            ((_cycle_mask & ICNT_MASK) && icnt_skipped == icnt_window)) {
+            // event cycle. leave it to the main loop
+            _core_time = core_time;
+            _dram_time = dram_time;
+            _icnt_time = icnt_time;
+            break;
+        }
+        if (_cycle_mask & CORE_MASK) core_skipped++;
+        if (_cycle_mask & DRAM_MASK) {
+            _dram->cycle();
+            if (_dram->cycles_to_next_event() == 0) {
+                // response is ready. icnt of this step should pop it in the main loop
+                if (_cycle_mask & ICNT_MASK) _icnt_time = icnt_time;
+                break;
+            }
+        }
+        if (_cycle_mask & ICNT_MASK) icnt_skipped++;
+    }
+
+    _client->skip_cycles(core_skipped);
+    _scheduler->skip_cycles(core_skipped);
+    if (core_ticks) {
+        for (int core_id = 0; core_id < _n_cores; core_id++) {
+            _cores[core_id]->skip_cycles(core_skipped);
+        }
+    }
+    _core_cycles += core_skipped;
+    _icnt->skip_cycles(icnt_skipped);
+}
+
+// A checkpoint is taken only when every memory access has been answered. Then the state is
+// just counters, stats and the KV cache / request bookkeeping, which is saved as json
+// (the NewtonSim controllers write their own dram.json).
+bool Simulator::checkpoint_ready() {
+    for (auto &core : _cores) {
+        if (!core->idle()) return false;
+    }
+    return _icnt->idle() && _dram->idle();
+}
+
+void Simulator::save_checkpoint() {
+    std::string stage = stageToString(_scheduler->get_prev_stage());
+    if (!checkpoint_ready()) {
+        spdlog::warn("Skip checkpoint of stage {}: memory accesses are in flight", stage);
+        return;
+    }
+    fs::path dir = fs::path(_config.checkpoint_dir) / stage;
+    fs::create_directories(dir);
+
+    json j;
+    j["model_name"] = _config.model_name;
+    j["core_cycles"] = _core_cycles;
+    j["core_time"] = _core_time;
+    j["dram_time"] = _dram_time;
+    j["icnt_time"] = _icnt_time;
+    j["stage_stats"] = json::array();
+    for (auto &stat : _stage_stats) {
+        j["stage_stats"].push_back({static_cast<int>(stat.stage), stat.done_cycle,
+                                    stat.pim_cycles, stat.npu_cycles, stat.mem_bw_util});
+    }
+    j["cores"] = json::array();
+    for (auto &core : _cores) {
+        json core_state;
+        core->save_state(core_state);
+        j["cores"].push_back(core_state);
+    }
+    _icnt->save_state(j["icnt"]);
+    _dram->save_state(j["dram"], (dir / "dram.json").string());
+    _scheduler->save_state(j["scheduler"]);
+    _client->save_state(j["client"]);
+    ActAlloc::GetInstance()->save_state(j["act_alloc"]);
+    KVCacheAlloc::GetInstance()->save_state(j["kv_cache_alloc"]);
+    save_global_state(j["global"]);
+
+    std::ofstream ofile(dir / "simulator.json");
+    if (!ofile.is_open()) {
+        assert(0);
+    }
+    ofile << j;
+    spdlog::info("Checkpoint of stage {} saved to {} at {}", stage, dir.string(), _core_cycles);
+}
+
+void Simulator::load_checkpoint(std::string path) {
+    fs::path dir(path);
+    std::ifstream ifile(dir / "simulator.json");
+    if (!ifile.is_open()) {
+        spdlog::error("Can't open checkpoint {}", path);
+        exit(-1);
+    }
+    json j;
+    ifile >> j;
+    ast(j["model_name"] == _config.model_name);
+    ast(j["cores"].size() == _n_cores);
+
+    _core_cycles = j["core_cycles"];
+    _core_time = j["core_time"];
+    _dram_time = j["dram_time"];
+    _icnt_time = j["icnt_time"];
+    _stage_stats.clear();
+    for (auto &stat : j["stage_stats"]) {
+        _stage_stats.push_back(StageStat{.stage = static_cast<Stage>(stat[0].get<int>()),
+                                         .done_cycle = stat[1],
+                                         .pim_cycles = stat[2],
+                                         .npu_cycles = stat[3],
+                                         .mem_bw_util = stat[4]});
+    }
+    for (int core_id = 0; core_id < _n_cores; core_id++) {
+        _cores[core_id]->load_state(j["cores"][core_id]);
+    }
+    _icnt->load_state(j["icnt"]);
+    _dram->load_state(j["dram"], (dir / "dram.json").string());
+    _scheduler->load_state(j["scheduler"]);
+    _client->load_state(j["client"]);
+    ActAlloc::GetInstance()->load_state(j["act_alloc"]);
+    KVCacheAlloc::GetInstance()->load_state(j["kv_cache_alloc"]);
+    load_global_state(j["global"]);
+
+    // the restored stage boundary is the one in the checkpoint
+    _checkpoint_taken = true;
+    spdlog::info("Restored checkpoint {} at {}", path, _core_cycles);
+}
+
 uint32_t Simulator::get_dest_node(MemoryAccess *access) {
     if (access->request) {
         // MemoryAccess not issued
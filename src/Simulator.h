@@ -26,9 +26,15 @@ private:
   void cycle();
   bool running();
   void set_cycle_mask();
+  void skip_idle_cycles();
   uint32_t get_dest_node(MemoryAccess *access);
   void update_stage_stat();
   void log_stage_stat();
+  void open_trace();
+  // checkpoint at stage boundaries (checkpoint_dir / restore_checkpoint)
+  bool checkpoint_ready();
+  void save_checkpoint();
+  void load_checkpoint(std::string path);
   SimulationConfig _config;
   uint32_t _n_cores;
   uint32_t _n_memories;
@@ -66,4 +72,6 @@ private:
   };
 
   std::vector<StageStat> _stage_stats;
+
+  bool _checkpoint_taken; // checkpoint of the current stage boundary is done
 };
\ No newline at end of file
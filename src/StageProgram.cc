@@ -160,12 +160,14 @@ void StageProgram::init_PIM_program() {
   for (int j = 0; j < sub_batch_size; j++) {
     /* - [] todo: change query to real query from gkv gen */
     Ptr<InferRequest> request = _breq->_reqs[j];
-    int q_len = request->is_initiated ? 1 : request->input_size;
-    assert(q_len == 1);
+    // Prefill requests (continuous batching) attend over the whole prompt.
+    // The MHA ops run this initiation phase on the NPU (q_len == seq_len).
+    uint32_t q_len = request->is_initiated ? 1 : request->input_size;
+    assert(q_len == 1 || q_len == request->K_cache[0]->get_dims()[2]);
 
     query = std::make_shared<NPUTensor>(
         "query",
-        std::vector<uint32_t>{num_heads, static_cast<unsigned int>(q_len), dk},
+        std::vector<uint32_t>{num_heads, q_len, dk},
         NPUTensorBufType::ACT, true);
     querys.push_back(query);
 
@@ -309,6 +311,7 @@ StageProgram::projection_block(std::vector<Ptr<BTensor>> inputs) {
                                _model->get_params(layer, BlockType::Attention,
                                                   OperationType::Projection)));
   inputs = get_outputs(projection, inputs);
+  inputs = all_reduce(prefix, inputs);
 
   // fixme: residual is not with this tensor.
   auto residual =
@@ -349,6 +352,7 @@ StageProgram::ffn_block(std::vector<Ptr<BTensor>> inputs) {
       _model->get_params(layer, BlockType::FeedForward,
                          OperationType::FullyConnected2)));
   inputs = get_outputs(fc2, inputs);
+  inputs = all_reduce(prefix, inputs);
 
   auto residual =
       add_op(std::make_shared<Add>(name_gen(prefix, OperationType::Residual)));
@@ -357,6 +361,19 @@ StageProgram::ffn_block(std::vector<Ptr<BTensor>> inputs) {
   return inputs;
 }
 
+// Projection and FFN2 are row-parallel over n_tp devices, so their outputs are
+// partial sums until they are all-reduced over the inter-device link.
+std::vector<Ptr<BTensor>>
+StageProgram::all_reduce(std::string prefix, std::vector<Ptr<BTensor>> inputs) {
+  if (Config::global_config.n_tp == 1 ||
+      Config::global_config.tp_allreduce == AllReduceAlgo::NONE)
+    return inputs;
+
+  auto all_reduce = add_op(
+      std::make_shared<AllReduce>(name_gen(prefix, OperationType::AllReduce)));
+  return get_outputs(all_reduce, inputs);
+}
+
 std::vector<Ptr<BTensor>>
 StageProgram::qkv_gen_block(std::vector<Ptr<BTensor>> inputs) {
   int layer = 0;
@@ -63,4 +63,6 @@ public:
   std::vector<Ptr<BTensor>> projection_block(std::vector<Ptr<BTensor>> inputs);
   std::vector<Ptr<BTensor>> ffn_block(std::vector<Ptr<BTensor>> inputs);
   std::vector<Ptr<BTensor>> qkv_gen_block(std::vector<Ptr<BTensor>> inputs);
+  std::vector<Ptr<BTensor>> all_reduce(std::string prefix,
+                                       std::vector<Ptr<BTensor>> inputs);
 };
\ No newline at end of file
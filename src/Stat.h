@@ -43,7 +43,7 @@ typedef struct NPUStat {
         }
     }
 
-    std::string get_by_enum(StatType stat_type) {
+    std::string get_by_enum(StatType stat_type) const {
         uint64_t core_cycle = Config::global_config.core_freq * 1000000;  // Mhz
 
         switch (stat_type) {
@@ -64,7 +64,7 @@ typedef struct NPUStat {
         return ret + "\n";
     }
 
-    std::string repr() {
+    std::string repr() const {
         std::string ret = "";
         for (auto type : get_stat_types()) {
             ret += get_by_enum(type) + "\t";
@@ -136,7 +136,7 @@ typedef struct MemoryIOStat {
         }
     }
 
-    std::string get_by_enum(StatType stat_type) {
+    std::string get_by_enum(StatType stat_type) const {
         uint64_t core_cycle = Config::global_config.core_freq * 1000000;  // Mhz
 
         switch (stat_type) {
@@ -169,7 +169,7 @@ typedef struct MemoryIOStat {
         return ret + "\n";
     }
 
-    std::string repr() {
+    std::string repr() const {
         std::string ret = "";
         for (auto type : get_stat_types()) {
             ret += get_by_enum(type) + "\t";
@@ -319,7 +319,7 @@ typedef struct OperationStat {
         }
     }
 
-    std::string get_by_enum(StatType stat_type) {
+    std::string get_by_enum(StatType stat_type) const {
         double npu_util;
         uint64_t total_cycle = end_cycle - start_cycle;
         uint64_t core_cycle = Config::global_config.core_freq * 1000000;
@@ -371,7 +371,7 @@ typedef struct OperationStat {
         return ret + "\n";
     }
 
-    std::string repr() {
+    std::string repr() const {
         std::string ret = "";
         if (end_cycle == 0) {
             return ret;
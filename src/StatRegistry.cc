@@ -0,0 +1,50 @@
+#include "StatRegistry.h"
+
+uint64_t &StatRegistry::counter(const std::string &scope, const std::string &name) {
+    // std::map keeps the node (and the reference) when other entries are inserted
+    return _scopes[scope].counters.emplace(name, 0).first->second;
+}
+
+StatRegistry::Histogram &StatRegistry::histogram(const std::string &scope,
+                                                 const std::string &name) {
+    return _scopes[scope].histograms[name];
+}
+
+StatRegistry::TimeSeries &StatRegistry::time_series(const std::string &scope,
+                                                    const std::string &name,
+                                                    const std::vector<std::string> &columns) {
+    auto &series = _scopes[scope].time_series[name];
+    if (series.columns.empty()) {
+        series.columns = columns;
+        series.values.resize(columns.size());
+    }
+    assert(series.columns == columns);
+    return series;
+}
+
+void StatRegistry::dump(std::string fname) {
+    json j = json::object();
+    for (auto &[scope_name, scope] : _scopes) {
+        json &out = j[scope_name];
+        for (auto &[name, value] : scope.counters) out["counters"][name] = value;
+        for (auto &[name, hist] : scope.histograms) {
+            out["histograms"][name] = {{"count", hist.count},
+                                       {"sum", hist.sum},
+                                       {"max", hist.max},
+                                       {"mean", hist.mean()},
+                                       {"log2_buckets", hist.buckets}};
+        }
+        for (auto &[name, series] : scope.time_series) {
+            json &columns = out["time_series"][name];
+            for (size_t i = 0; i < series.columns.size(); i++)
+                columns[series.columns[i]] = series.values[i];
+        }
+    }
+
+    std::ofstream ofile(fname);
+    if (!ofile.is_open()) {
+        assert(0);
+    }
+    ofile << j.dump(2) << std::endl;
+    ofile.close();
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Common.h"
+
+/**
+ * StatRegistry: named stats of every component, grouped by scope
+ *  (e.g. "core0", "icnt", "dram").
+ *  A component looks a stat up once and keeps the reference, so updates on
+ *  the hot path are plain increments. Entries are never removed, so the
+ *  references stay valid until the end of the simulation.
+ *   - counter: uint64_t
+ *   - histogram: count / sum / max and log2 buckets of the samples
+ *   - time series: named columns, one row per sample, stored column-wise
+ *  Everything is dumped once as a single json (scope -> kind -> name).
+ */
+class StatRegistry : public Singleton<StatRegistry> {
+   private:
+    friend class Singleton;
+    StatRegistry() = default;
+    ~StatRegistry() = default;
+
+   public:
+    struct Histogram {
+        uint64_t count = 0;
+        uint64_t sum = 0;
+        uint64_t max = 0;
+        // [0]: zeros, [i]: samples in [2^(i-1), 2^i)
+        std::vector<uint64_t> buckets;
+
+        void add(uint64_t value) {
+            count++;
+            sum += value;
+            max = MAX(max, value);
+            uint32_t bucket = value == 0 ? 0 : 64 - __builtin_clzll(value);
+            if (bucket >= buckets.size()) buckets.resize(bucket + 1, 0);
+            buckets[bucket]++;
+        }
+        double mean() const { return count == 0 ? 0 : (double)sum / count; }
+    };
+
+    struct TimeSeries {
+        std::vector<std::string> columns;
+        std::vector<std::vector<double>> values;  // values[column][row]
+
+        void append(const std::vector<double> &row) {
+            assert(row.size() == columns.size());
+            for (size_t i = 0; i < row.size(); i++) values[i].push_back(row[i]);
+        }
+        size_t size() const { return values.empty() ? 0 : values[0].size(); }
+    };
+
+    uint64_t &counter(const std::string &scope, const std::string &name);
+    Histogram &histogram(const std::string &scope, const std::string &name);
+    TimeSeries &time_series(const std::string &scope, const std::string &name,
+                            const std::vector<std::string> &columns);
+
+    void dump(std::string fname);
+
+   private:
+    struct Scope {
+        std::map<std::string, uint64_t> counters;
+        std::map<std::string, Histogram> histograms;
+        std::map<std::string, TimeSeries> time_series;
+    };
+    std::map<std::string, Scope> _scopes;
+};
@@ -14,7 +14,7 @@ void SystolicWS::cycle() {
         } else {
             assert(0);
         }
-        if (auto tile = inst.parent_tile.lock()) {
+        if (auto tile = inst.parent_tile.get()) {
             tile->remaining_accum_io--;
             tile->remaining_computes--;
         } else {
@@ -43,7 +43,7 @@ void SystolicWS::cycle() {
             } else {
                 assert(0);
             }
-            if (auto tile = inst.parent_tile.lock()) {
+            if (auto tile = inst.parent_tile.get()) {
                 tile->remaining_accum_io--;
                 tile->remaining_computes--;
             } else {
@@ -79,7 +79,7 @@ void SystolicWS::cycle() {
 
             // xxx is this right? size, count<<src_addrs size
             buffer->reserve(front.dest_addr, buffer_id, front.size, accesses.size());
-            if (auto tile = front.parent_tile.lock()) {
+            if (auto tile = front.parent_tile.get()) {
                 tile->remaining_loads += accesses.size() - 1;
                 tile->stat.memory_reads += accesses.size() * AddressConfig::alignment;
             } else {
@@ -137,7 +137,7 @@ void SystolicWS::cycle() {
             auto accesses = MemoryAccess::from_instruction(
                 front, generate_mem_access_id(), _config.dram_req_size, MemoryAccessType::WRITE,
                 true, _id, _core_cycle, buffer_id, StagePlatform::SA);
-            if (auto tile = front.parent_tile.lock()) {
+            if (auto tile = front.parent_tile.get()) {
                 tile->remaining_accum_io += accesses.size() - 1;
                 tile->stat.memory_writes += accesses.size() * AddressConfig::alignment;
             } else {
@@ -187,7 +187,7 @@ void SystolicWS::cycle() {
     // }
 
     if (!_compute_pipeline.empty()) {
-        auto parent_tile = _compute_pipeline.front().parent_tile.lock();
+        auto parent_tile = _compute_pipeline.front().parent_tile.get();
         if (parent_tile == nullptr) {
             assert(0);
         }
@@ -195,7 +195,7 @@ void SystolicWS::cycle() {
     }
     for (auto &vector_pipeline : _vector_pipelines) {
         if (!vector_pipeline.empty()) {
-            auto parent_tile = vector_pipeline.front().parent_tile.lock();
+            auto parent_tile = vector_pipeline.front().parent_tile.get();
             if (parent_tile == nullptr) {
                 assert(0);
             }
@@ -232,6 +232,8 @@ void SystolicWS::cycle() {
                 case Opcode::GELU:
                     _gelu_stall_cycle++;
                     break;
+                case Opcode::ALLREDUCE:
+                    break;
             }
         }
     } else if (!_compute_pipeline.empty()) {
@@ -253,6 +255,8 @@ void SystolicWS::cycle() {
                 case Opcode::GELU:
                     _stat_gelu_cycle++;
                     break;
+                case Opcode::ALLREDUCE:
+                    break;
             }
         }
     }
@@ -290,8 +294,11 @@ cycle_type SystolicWS::get_vector_compute_cycles(Instruction &inst) {
             return vec_op_iter * _config.gelu_latency;
         case Opcode::DUMMY:
             return 1;
+        case Opcode::ALLREDUCE:
+            // runs on the tp link of NeuPIMSystolicWS, not on the vector units
+            return 0;
     }
-    spdlog::info("not configured operation. {}", inst.id);
+    spdlog::info("not configured operation. {}", opcodeTypeString(inst.opcode));
     // assert(0);
     return 0;
 }
@@ -329,7 +336,7 @@ void SystolicWS::print_stats() {
 void SystolicWS::issue_ex_inst(Instruction inst) {
     // spdlog::info("cycle:{}, {}", _core_cycle, inst.repr());
     if (inst.opcode == Opcode::GEMM || inst.opcode == Opcode::GEMM_PRELOAD) {
-        auto parent_tile = inst.parent_tile.lock();
+        auto parent_tile = inst.parent_tile.get();
         if (parent_tile == nullptr) {
             assert(0);
         }
@@ -0,0 +1,100 @@
+#include "Tracer.h"
+
+void Tracer::open(std::string fname) {
+    assert(!_enabled);
+    _file.open(fname);
+    if (!_file.is_open()) {
+        spdlog::error("Can't open trace file {}", fname);
+        exit(-1);
+    }
+    spdlog::info("Trace to {}", fname);
+    _file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    _first_event = true;
+    _closing = false;
+    _buffer.reserve(BUFFER_EVENTS);
+    _writer = std::thread(&Tracer::write_loop, this);
+    _enabled = true;
+}
+
+void Tracer::close() {
+    if (!_enabled) return;
+    flush_buffer();
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _closing = true;
+    }
+    _cv.notify_one();
+    _writer.join();
+    _file << "\n]}\n";
+    _file.close();
+    _enabled = false;
+}
+
+void Tracer::complete(uint32_t pid, uint32_t tid, const std::string &name, double ts,
+                      double dur) {
+    push(Event{.phase = 'X', .pid = pid, .tid = tid, .name = name, .ts = ts, .dur = dur});
+}
+
+void Tracer::instant(uint32_t pid, uint32_t tid, const std::string &name, double ts) {
+    push(Event{.phase = 'i', .pid = pid, .tid = tid, .name = name, .ts = ts, .dur = 0});
+}
+
+void Tracer::name_process(uint32_t pid, const std::string &name) {
+    push(Event{.phase = 'P', .pid = pid, .tid = 0, .name = name, .ts = 0, .dur = 0});
+}
+
+void Tracer::name_track(uint32_t pid, uint32_t tid, const std::string &name) {
+    push(Event{.phase = 'T', .pid = pid, .tid = tid, .name = name, .ts = 0, .dur = 0});
+}
+
+void Tracer::push(Event &&event) {
+    _buffer.push_back(std::move(event));
+    if (_buffer.size() >= BUFFER_EVENTS) flush_buffer();
+}
+
+void Tracer::flush_buffer() {
+    if (_buffer.empty()) return;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _full_buffers.push_back(std::move(_buffer));
+    }
+    _cv.notify_one();
+    _buffer = std::vector<Event>();
+    _buffer.reserve(BUFFER_EVENTS);
+}
+
+void Tracer::write_loop() {
+    while (true) {
+        std::vector<Event> events;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _cv.wait(lock, [this] { return !_full_buffers.empty() || _closing; });
+            if (_full_buffers.empty()) return;
+            events = std::move(_full_buffers.front());
+            _full_buffers.pop_front();
+        }
+        write_events(events);
+    }
+}
+
+void Tracer::write_events(const std::vector<Event> &events) {
+    for (auto &event : events) {
+        if (!_first_event) _file << ",\n";
+        _first_event = false;
+        if (event.phase == 'P' || event.phase == 'T') {
+            // metadata, the name goes to args.name
+            _file << fmt::format(
+                "{{\"ph\":\"M\",\"pid\":{},\"tid\":{},\"name\":\"{}\",\"args\":{{\"name\":{}}}}}",
+                event.pid, event.tid, event.phase == 'P' ? "process_name" : "thread_name",
+                json(event.name).dump());
+        } else if (event.phase == 'X') {
+            _file << fmt::format(
+                "{{\"ph\":\"X\",\"pid\":{},\"tid\":{},\"name\":{},\"ts\":{:.3f},\"dur\":{:.3f}}}",
+                event.pid, event.tid, json(event.name).dump(), event.ts, event.dur);
+        } else {
+            _file << fmt::format(
+                "{{\"ph\":\"i\",\"s\":\"t\",\"pid\":{},\"tid\":{},\"name\":{},\"ts\":{:.3f}}}",
+                event.pid, event.tid, json(event.name).dump(), event.ts);
+        }
+    }
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Common.h"
+
+/**
+ * Tracer: opt-in timeline in Chrome Trace Event format
+ *  (open with chrome://tracing or ui.perfetto.dev), enabled by `trace`.
+ *  The simulation thread only appends events to a buffer. Full buffers are
+ *  handed to a writer thread that formats and writes them to the file.
+ *
+ *  A process (pid) is a component and a thread (tid) is a track in it:
+ *   - TRACE_PID_SCHEDULER: stages, and the finish of each operation (instant)
+ *   - TRACE_PID_DRAM: PIM command bursts of each channel
+ *   - TRACE_PID_CORE + core_id: tiles of each StagePlatform, the systolic
+ *     pipeline, the tp all-reduce link and each vector pipeline
+ *  Timestamps are in us, converted from the cycles of each clock domain.
+ */
+enum TracePid : uint32_t { TRACE_PID_SCHEDULER = 0, TRACE_PID_DRAM = 1, TRACE_PID_CORE = 2 };
+enum TraceSchedulerTid : uint32_t { TRACE_TID_STAGE = 0, TRACE_TID_OPERATION = 1 };
+enum TraceCoreTid : uint32_t {
+    TRACE_TID_SA_TILE = 0,
+    TRACE_TID_PIM_TILE = 1,
+    TRACE_TID_SYSTOLIC = 2,
+    TRACE_TID_LINK = 3,
+    TRACE_TID_VECTOR = 4  // + vector pipeline index
+};
+
+class Tracer : public Singleton<Tracer> {
+   private:
+    friend class Singleton;
+    Tracer() = default;
+    ~Tracer() = default;
+
+   public:
+    void open(std::string fname);
+    void close();
+    bool enabled() const { return _enabled; }
+
+    // ts, dur: us
+    void complete(uint32_t pid, uint32_t tid, const std::string &name, double ts, double dur);
+    void instant(uint32_t pid, uint32_t tid, const std::string &name, double ts);
+    void name_process(uint32_t pid, const std::string &name);
+    void name_track(uint32_t pid, uint32_t tid, const std::string &name);
+
+    static double core_us(cycle_type cycle) {
+        return (double)cycle / Config::global_config.core_freq;
+    }
+    static double dram_us(cycle_type cycle) {
+        return (double)cycle / Config::global_config.dram_freq;
+    }
+
+   private:
+    struct Event {
+        char phase;  // X: complete, i: instant, P / T: process / track name
+        uint32_t pid;
+        uint32_t tid;
+        std::string name;
+        double ts;
+        double dur;
+    };
+    static constexpr size_t BUFFER_EVENTS = 1 << 16;
+
+    bool _enabled = false;
+    std::vector<Event> _buffer;
+
+    // writer thread
+    std::ofstream _file;
+    bool _first_event;
+    std::thread _writer;
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    std::deque<std::vector<Event>> _full_buffers;
+    bool _closing;
+
+    void push(Event &&event);
+    void flush_buffer();
+    void write_loop();
+    void write_events(const std::vector<Event> &events);
+};
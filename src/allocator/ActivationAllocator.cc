@@ -45,4 +45,8 @@ addr_type ActAlloc::get_next_aligned_addr() {
 // 将分配指针重置回基地址。
 // 这意味着所有之前分配的激活值都被视为“释放”，可以被新一轮计算覆盖。
 // 通常在每个推理 Step 结束后调用。
-void ActAlloc::flush() { _top_addr = _base_addr; }
\ No newline at end of file
+void ActAlloc::flush() { _top_addr = _base_addr; }
+
+void ActAlloc::save_state(json &j) { j["top_addr"] = _top_addr; }
+
+void ActAlloc::load_state(const json &j) { _top_addr = j["top_addr"]; }
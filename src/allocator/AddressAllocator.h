@@ -41,6 +41,10 @@ public:
   addr_type
   get_next_aligned_addr(); // aligned limit addr + alignment of ActAlloc buf
   void flush();
+
+  // checkpoint (检查点保存/恢复分配指针)
+  void save_state(json &j);
+  void load_state(const json &j);
 };
 
 // KV Cache 分配器 (KV Cache Allocator)
@@ -73,11 +77,31 @@ public:
   uint32_t _num_ele_per_row; // DRAM row size / precision (每行能存多少个元素)
   uint32_t _bank_per_ch; // 每个 Channel 的 Bank 数量
 
-  // channel -> free rows base index
+  // channel -> free blocks (base row index)
   // 这是一个二维结构，第一维是 Channel，第二维是该 Channel
-  // 下可用的空闲行索引列表。 PIMTensor 会根据 Channel ID 向这里申请空闲行。
+  // 下可用的空闲块（起始行索引）列表。 PIMTensor 会根据 Channel ID
+  // 向这里申请空闲块，块内的行由 PIMTensor 依次使用。
   std::vector<Ptr<std::deque<uint64_t>>> _rows;
 
+  // paged KV cache: a block is _block_rows consecutive rows of a channel
+  // (分页 KV Cache：每个块为同一 Channel 的 _block_rows 个连续行)
+  typedef struct {
+    uint32_t used_rows; // rows holding KV (已使用的行数)
+  } BlockState;
+  uint32_t _block_rows;
+  uint64_t _blocks_per_ch;
+  // channel -> allocated block -> state
+  std::vector<robin_hood::unordered_map<uint64_t, BlockState>> _blocks;
+
+  // occupancy / fragmentation over time (sampled at stage boundaries)
+  typedef struct {
+    cycle_type cycle;
+    uint64_t allocated_blocks; // all channels
+    uint64_t used_rows;        // all channels
+    uint64_t max_ch_blocks;    // the most occupied channel
+  } BlockUsage;
+  std::vector<BlockUsage> _usage_log;
+
   void init(addr_type base_addr);
 
   // 初始化 NPU 布局：线性切分 memory pool
@@ -89,9 +113,21 @@ public:
   // NPU 分配接口：从 _kv_cache 队列取一个地址
   addr_type allocate();
 
-  // PIM 分配接口：指定 Channel，从对应的 _rows[ch] 队列取一个行索引
+  // PIM 分配接口：指定 Channel，从对应的 _rows[ch] 队列取一个块
   addr_type allocate(uint64_t ch);
+  // 块内新使用一行
+  void use_row(uint32_t ch, uint64_t block);
 
   void free(addr_type addr);
-  void free(uint32_t ch, uint64_t row);
+  // 立即回收该块 (块只属于一个 K/V 张量)
+  void free(uint32_t ch, uint64_t block);
+
+  // occupancy (allocated / total blocks) and fragmentation (unused rows of
+  // allocated blocks) -> _kv_cache.tsv
+  void record_usage(cycle_type cycle);
+  void print_stat();
+
+  // checkpoint (检查点保存/恢复空闲块和空闲行)
+  void save_state(json &j);
+  void load_state(const json &j);
 };
\ No newline at end of file
@@ -118,15 +118,17 @@ void KVCacheAlloc::init_pim_layout(addr_type base_addr) {
   _base_addr = base_addr;
   _base_row = base_addr >> row_offset; // 获取行索引 (去除低位偏移)
 
-  // _rows: channel -> row idx (双端队列，存储每个通道的空闲行索引)
+  // _rows: channel -> block base row idx
+  // (双端队列，存储每个通道的空闲块起始行索引)
+  _block_rows = Config::global_config.kv_block_rows;
   uint32_t free_rows_size = row_per_bank - _base_row;
+  _blocks_per_ch = free_rows_size / _block_rows;
+  _blocks.resize(_dram_channels);
   for (int i = 0; i < _dram_channels; ++i) {
     _rows.push_back(
         std::make_shared<std::deque<uint64_t>>()); // 为每个通道创建一个deque
-    for (int j = 0; j < free_rows_size; ++j) {
-      if (_base_row + j < row_per_bank)
-        _rows[i]->push_back(_base_row + j); // 将空闲的行索引加入队列
-    }
+    for (uint64_t j = 0; j < _blocks_per_ch; ++j)
+      _rows[i]->push_back(_base_row + j * _block_rows); // 将空闲块加入队列
   }
 }
 
@@ -140,13 +142,20 @@ addr_type KVCacheAlloc::allocate() {
   return addr;
 }
 
-// PIM分配: 从指定通道分配一个空闲行
+// PIM分配: 从指定通道分配一个空闲块
 addr_type KVCacheAlloc::allocate(uint64_t ch) {
   ast(_mode == RunMode::NPU_PIM);
   ast(_rows[ch]->size() > 0);
-  addr_type row = _rows[ch]->front();
+  addr_type block = _rows[ch]->front();
   _rows[ch]->pop_front();
-  return row; // return free row (返回空闲行索引)
+  _blocks[ch][block] = BlockState{.used_rows = 0};
+  return block; // return base row of the block (返回块的起始行索引)
+}
+
+void KVCacheAlloc::use_row(uint32_t ch, uint64_t block) {
+  auto &state = _blocks[ch].at(block);
+  ast(state.used_rows < _block_rows);
+  state.used_rows++;
 }
 
 // NPU释放: 释放指定的地址回KV Cache空闲列表
@@ -155,8 +164,105 @@ void KVCacheAlloc::free(addr_type addr) {
   _kv_cache.push_back(addr);
 }
 
-// PIM释放: 释放指定通道的行回空闲列表
-void KVCacheAlloc::free(uint32_t ch, uint64_t row) {
+// PIM释放: 立即将块放回空闲列表
+void KVCacheAlloc::free(uint32_t ch, uint64_t block) {
   ast(_mode == RunMode::NPU_PIM);
-  _rows[ch]->push_back(row);
-}
\ No newline at end of file
+  auto it = _blocks[ch].find(block);
+  ast(it != _blocks[ch].end());
+  _blocks[ch].erase(it);
+  _rows[ch]->push_back(block);
+}
+
+void KVCacheAlloc::record_usage(cycle_type cycle) {
+  if (_mode != RunMode::NPU_PIM)
+    return;
+  BlockUsage usage{
+      .cycle = cycle, .allocated_blocks = 0, .used_rows = 0, .max_ch_blocks = 0};
+  for (auto &blocks : _blocks) {
+    usage.allocated_blocks += blocks.size();
+    usage.max_ch_blocks = MAX(usage.max_ch_blocks, (uint64_t)blocks.size());
+    for (auto &block : blocks)
+      usage.used_rows += block.second.used_rows;
+  }
+  _usage_log.push_back(usage);
+}
+
+/**
+ * occupancy: allocated blocks / blocks of all channels
+ * fragmentation: rows of allocated blocks which hold no KV (internal
+ * fragmentation of the last block of each tensor)
+ */
+void KVCacheAlloc::print_stat() {
+  if (_mode != RunMode::NPU_PIM || _usage_log.empty())
+    return;
+
+  std::string fname = Config::global_config.log_dir + "/_kv_cache.tsv";
+  std::ofstream ofile(fname);
+  ast(ofile.is_open());
+  ofile << "cycle\tallocated_blocks\tused_rows\toccupancy\tmax_ch_occupancy\t"
+           "fragmentation\t\n";
+
+  uint64_t total_blocks = _blocks_per_ch * _dram_channels;
+  double peak_occupancy = 0, peak_ch_occupancy = 0, peak_fragmentation = 0;
+  for (auto &usage : _usage_log) {
+    uint64_t allocated_rows = usage.allocated_blocks * _block_rows;
+    double occupancy = (double)usage.allocated_blocks / total_blocks;
+    double ch_occupancy = (double)usage.max_ch_blocks / _blocks_per_ch;
+    double fragmentation =
+        allocated_rows > 0 ? 1 - (double)usage.used_rows / allocated_rows : 0;
+    peak_occupancy = MAX(peak_occupancy, occupancy);
+    peak_ch_occupancy = MAX(peak_ch_occupancy, ch_occupancy);
+    peak_fragmentation = MAX(peak_fragmentation, fragmentation);
+
+    ofile << usage.cycle << "\t" << usage.allocated_blocks << "\t"
+          << usage.used_rows << "\t" << occupancy << "\t" << ch_occupancy
+          << "\t" << fragmentation << "\t\n";
+  }
+  ofile.close();
+
+  spdlog::info("KV cache: {} blocks x {} rows per channel, peak occupancy "
+               "{:.4f} (channel {:.4f}), peak fragmentation {:.4f}",
+               _blocks_per_ch, _block_rows, peak_occupancy, peak_ch_occupancy,
+               peak_fragmentation);
+}
+
+void KVCacheAlloc::save_state(json &j) {
+  if (_mode == RunMode::NPU_ONLY) {
+    j["kv_cache"] = _kv_cache;
+  } else {
+    j["rows"] = json::array();
+    for (auto &rows : _rows)
+      j["rows"].push_back(*rows);
+    j["blocks"] = json::array();
+    for (auto &blocks : _blocks) {
+      json ch_blocks = json::array();
+      for (auto &block : blocks)
+        ch_blocks.push_back({block.first, block.second.used_rows});
+      j["blocks"].push_back(ch_blocks);
+    }
+    j["usage_log"] = json::array();
+    for (auto &usage : _usage_log)
+      j["usage_log"].push_back({usage.cycle, usage.allocated_blocks,
+                                usage.used_rows, usage.max_ch_blocks});
+  }
+}
+
+void KVCacheAlloc::load_state(const json &j) {
+  if (_mode == RunMode::NPU_ONLY) {
+    _kv_cache = j["kv_cache"].get<std::deque<addr_type>>();
+  } else {
+    ast(j["rows"].size() == _rows.size());
+    for (size_t ch = 0; ch < _rows.size(); ++ch) {
+      *_rows[ch] = j["rows"][ch].get<std::deque<uint64_t>>();
+      _blocks[ch].clear();
+      for (auto &block : j["blocks"][ch])
+        _blocks[ch][block[0]] = BlockState{.used_rows = block[1]};
+    }
+    _usage_log.clear();
+    for (auto &usage : j["usage_log"])
+      _usage_log.push_back(BlockUsage{.cycle = usage[0],
+                                      .allocated_blocks = usage[1],
+                                      .used_rows = usage[2],
+                                      .max_ch_blocks = usage[3]});
+  }
+}
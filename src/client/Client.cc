@@ -1,5 +1,9 @@
 #include "Client.h"
 
+#include "../BatchedRequest.h"
+
+static uint32_t rid{0};
+
 Client::Client(SimulationConfig config)
     : _config(config),
       _cycles(0),
@@ -12,9 +16,7 @@ Client::Client(SimulationConfig config)
     // - total number of requests
     // - request size (input,output)
 
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    _gen = gen;
+    _gen.seed(_config.request_seed);
 
     // todo: get from config
     _imin = 10;
@@ -28,21 +30,47 @@ Client::Client(SimulationConfig config)
     // _total_cnt = _config.request_total_cnt;
     _total_cnt = RequestGenerator::get_total_req_cnt();
     spdlog::info("Client total request cnt: {}", _total_cnt);
-    _request_interval = _config.request_interval;
+    _request_interval = 0;
+    if (_config.request_arrival == ArrivalMode::FIXED ||
+        _config.request_arrival == ArrivalMode::POISSON) {
+        _request_interval = _config.core_freq * 1e6 / _config.request_qps;  // core_freq in MHz
+        spdlog::info("Client request interval: {} cycles", _request_interval);
+    }
+    if (_config.request_arrival == ArrivalMode::TRACE) ast(RequestGenerator::arrival_index >= 0);
 
-    std::poisson_distribution<> d(_request_interval);
+    std::exponential_distribution<> d(1.0 / MAX(_request_interval, 1));
     _distribution = d;
     _touch = false;
+
+    // the first request of a trace arrives at its timestamp
+    if (_config.request_arrival == ArrivalMode::TRACE && RequestGenerator::has_data())
+        _need_wait_cycles = next_request_wait();
 }
 
 int Client::rand_input_size() { return rand() % (_imax - _imin) + _imin; }
 int Client::rand_output_size() { return rand() % (_omax - _omin) + _omin; }
 
+cycle_type Client::next_request_wait() {
+    switch (_config.request_arrival) {
+        case ArrivalMode::FIXED:
+            return _request_interval;
+        case ArrivalMode::POISSON:
+            return std::llround(_distribution(_gen));
+        case ArrivalMode::TRACE: {
+            if (!RequestGenerator::has_data()) return 0;
+            cycle_type arrival_cycle =
+                (cycle_type)RequestGenerator::get_arrival_us() * _config.core_freq;
+            return arrival_cycle > _cycles ? arrival_cycle - _cycles : 0;
+        }
+        default:
+            return 0;
+    }
+}
+
 void Client::cycle() {
-    uint32_t idle_cycles = _cycles - _last_request_cycle;
-    // return; // FIXME: comment
-    // FIXME: change while to if
-    while (!_touch) {
+    // issue every request whose arrival time has come
+    while (!_touch && _cycles - _last_request_cycle >= _need_wait_cycles) {
+        cycle_type idle_cycles = _cycles - _last_request_cycle;
         // todo: send request to scheduler
         uint32_t rid = generate_rid();
 
@@ -59,8 +87,13 @@ void Client::cycle() {
             // exit(-1);
         }
         uint32_t input_size = input_output_size.first;
-        uint32_t output_size = 1;  // input_output_size.second;  // 1;
-        uint32_t channel = input_output_size.second;
+        uint32_t output_size = _config.request_output_size;  // input_output_size.second;  // 1;
+        // -1: placed by the scheduler when it is admitted
+        int channel = -1;
+        if (_config.channel_placement == ChannelPlacement::TRACE) {
+            ast(input_output_size.second != UINT32_MAX);
+            channel = input_output_size.second;
+        }
         std::shared_ptr<InferRequest> request =
             std::make_shared<InferRequest>(InferRequest{.id = rid,
                                                         .arrival_cycle = _cycles,
@@ -78,9 +111,8 @@ void Client::cycle() {
         _last_request_cycle = _cycles;
 
         // set next request interval
-        spdlog::info("xyz");
-        _need_wait_cycles = 0;  // _distribution(_gen);
-        spdlog::info("xyz");
+        _need_wait_cycles = next_request_wait();
+        if (!RequestGenerator::has_data()) _touch = true;
 
         spdlog::info("Client Request Departure!! now:{} next wait: {}", _cycles, _need_wait_cycles);
         spdlog::info("Request #{}, input size:{}, output size:{}", rid, input_size, output_size);
@@ -94,6 +126,14 @@ void Client::cycle() {
     }
 }
 
+cycle_type Client::cycles_to_next_event() {
+    if (has_request()) return 0;
+    if (_touch) return std::numeric_limits<cycle_type>::max();
+
+    cycle_type idle_cycles = _cycles - _last_request_cycle;
+    return idle_cycles >= _need_wait_cycles ? 0 : _need_wait_cycles - idle_cycles;
+}
+
 bool Client::running() {
     return _completed_cnt < _total_cnt;  // FIXME: comment
     return false;
@@ -113,14 +153,177 @@ void Client::receive_response(std::shared_ptr<InferRequest> response) {
     response->completed_cycle = _cycles;
     _completed_cnt++;
 
+    ast(response->token_cycles.size() == response->output_size);
+    _latencies.push_back(RequestLatency{.id = response->id,
+                                        .input_size = response->input_size,
+                                        .output_size = response->output_size,
+                                        .arrival_cycle = response->arrival_cycle,
+                                        .first_token_cycle = response->token_cycles.front(),
+                                        .last_token_cycle = response->token_cycles.back(),
+                                        .completed_cycle = response->completed_cycle});
+
     // spdlog::info("Receive response! spend_cycles: {}",
     //              response->completed_cycle - response->arrival_cycle);
 
-    // todo stat.
     // delete response;
 }
 
-uint32_t generate_rid() {
-    static uint32_t rid{0};
-    return rid++;
+double Client::cycles_to_ms(double cycles) {
+    return cycles / (_config.core_freq * 1e3);  // core_freq in MHz
 }
+
+// mean, percentiles (nearest rank) and a 10-bin histogram of latencies in ms
+static json latency_summary(std::vector<double> values) {
+    json j;
+    j["count"] = values.size();
+    if (values.empty()) return j;
+
+    std::sort(values.begin(), values.end());
+    double sum = 0;
+    for (double value : values) sum += value;
+    auto percentile = [&](double p) {
+        int rank = std::ceil(p / 100 * values.size());
+        return values[MAX(rank, 1) - 1];
+    };
+    j["mean"] = sum / values.size();
+    j["p50"] = percentile(50);
+    j["p90"] = percentile(90);
+    j["p99"] = percentile(99);
+    j["max"] = values.back();
+
+    const int n_bins = 10;
+    double lo = values.front();
+    double width = (values.back() - lo) / n_bins;
+    std::vector<uint32_t> counts(n_bins, 0);
+    for (double value : values) {
+        int bin = width > 0 ? (int)((value - lo) / width) : 0;
+        counts[MIN(bin, n_bins - 1)]++;
+    }
+    std::vector<double> edges;
+    for (int i = 0; i <= n_bins; i++) edges.push_back(lo + width * i);
+    j["histogram"] = {{"bin_edges", edges}, {"counts", counts}};
+    return j;
+}
+
+/**
+ * Latency of completed requests
+ *  TTFT: arrival -> first token, TPOT: mean interval of the following tokens,
+ *  E2E: arrival -> response. Goodput counts the requests which meet both
+ *  slo_ttft_ms and slo_tpot_ms (0 means no limit).
+ */
+void Client::print_stat() {
+    if (_latencies.empty()) return;
+
+    std::string fname = _config.log_dir + "/_latency.tsv";
+    std::ofstream ofile(fname);
+    ast(ofile.is_open());
+    ofile << "id\tinput_size\toutput_size\tarrival_cycle\tfirst_token_cycle\tcompleted_cycle\t"
+             "ttft_ms\ttpot_ms\te2e_ms\tslo_met\t\n";
+
+    std::vector<double> ttfts, tpots, e2es;
+    uint32_t good_reqs = 0;
+    uint64_t good_tokens = 0;
+    cycle_type end_cycle = 0;
+    for (auto &latency : _latencies) {
+        double ttft = cycles_to_ms(latency.first_token_cycle - latency.arrival_cycle);
+        double e2e = cycles_to_ms(latency.completed_cycle - latency.arrival_cycle);
+        double tpot = 0;
+        if (latency.output_size > 1) {
+            tpot = cycles_to_ms(latency.last_token_cycle - latency.first_token_cycle) /
+                   (latency.output_size - 1);
+            tpots.push_back(tpot);
+        }
+        ttfts.push_back(ttft);
+        e2es.push_back(e2e);
+        end_cycle = MAX(end_cycle, latency.completed_cycle);
+
+        bool slo_met = (_config.slo_ttft_ms == 0 || ttft <= _config.slo_ttft_ms) &&
+                       (_config.slo_tpot_ms == 0 || tpot <= _config.slo_tpot_ms);
+        if (slo_met) {
+            good_reqs++;
+            good_tokens += latency.output_size;
+        }
+
+        ofile << latency.id << "\t" << latency.input_size << "\t" << latency.output_size << "\t"
+              << latency.arrival_cycle << "\t" << latency.first_token_cycle << "\t"
+              << latency.completed_cycle << "\t" << ttft << "\t" << tpot << "\t" << e2e << "\t"
+              << slo_met << "\t\n";
+    }
+    ofile.close();
+
+    double elapsed_sec = cycles_to_ms(end_cycle) / 1e3;
+    json j;
+    j["ttft_ms"] = latency_summary(ttfts);
+    j["tpot_ms"] = latency_summary(tpots);
+    j["e2e_ms"] = latency_summary(e2es);
+    j["slo"] = {{"ttft_ms", _config.slo_ttft_ms}, {"tpot_ms", _config.slo_tpot_ms}};
+    j["completed_reqs"] = _latencies.size();
+    j["slo_met_reqs"] = good_reqs;
+    j["goodput_reqs_per_sec"] = elapsed_sec > 0 ? good_reqs / elapsed_sec : 0;
+    j["goodput_tokens_per_sec"] = elapsed_sec > 0 ? good_tokens / elapsed_sec : 0;
+
+    fname = _config.log_dir + "/_latency.json";
+    ofile.open(fname);
+    ast(ofile.is_open());
+    ofile << j.dump(2) << "\n";
+    ofile.close();
+
+    spdlog::info("Latency (ms) TTFT p50 {:.3f} p99 {:.3f}, E2E p50 {:.3f} p99 {:.3f}",
+                 j["ttft_ms"]["p50"].get<double>(), j["ttft_ms"]["p99"].get<double>(),
+                 j["e2e_ms"]["p50"].get<double>(), j["e2e_ms"]["p99"].get<double>());
+    spdlog::info("Goodput: {}/{} requests meet the SLO, {:.2f} requests/s",
+                 good_reqs, _latencies.size(), j["goodput_reqs_per_sec"].get<double>());
+}
+
+void Client::save_state(json &j) {
+    j["total_cnt"] = _total_cnt;
+    j["cycles"] = _cycles;
+    j["last_request_cycle"] = _last_request_cycle;
+    j["need_wait_cycles"] = _need_wait_cycles;
+    j["issued_cnt"] = _issued_cnt;
+    j["completed_cnt"] = _completed_cnt;
+    j["touch"] = _touch;
+    std::stringstream gen_state;
+    gen_state << _gen;
+    j["gen"] = gen_state.str();
+    j["latencies"] = json::array();
+    for (auto &latency : _latencies) {
+        j["latencies"].push_back({latency.id, latency.input_size, latency.output_size,
+                                  latency.arrival_cycle, latency.first_token_cycle,
+                                  latency.last_token_cycle, latency.completed_cycle});
+    }
+    j["waiting_queue"] = json::array();
+    for (auto queue = _waiting_queue; !queue.empty(); queue.pop())
+        j["waiting_queue"].push_back(request_to_json(queue.front()));
+    j["row_index"] = RequestGenerator::row_index;
+    j["rid"] = rid;
+}
+
+void Client::load_state(const json &j) {
+    // checkpoint must be taken with the same request trace
+    ast(j["total_cnt"] == _total_cnt);
+    _cycles = j["cycles"];
+    _last_request_cycle = j["last_request_cycle"];
+    _need_wait_cycles = j["need_wait_cycles"];
+    _issued_cnt = j["issued_cnt"];
+    _completed_cnt = j["completed_cnt"];
+    _touch = j["touch"];
+    std::stringstream gen_state(j["gen"].get<std::string>());
+    gen_state >> _gen;
+    _latencies.clear();
+    for (auto &latency : j["latencies"]) {
+        _latencies.push_back(RequestLatency{.id = latency[0],
+                                            .input_size = latency[1],
+                                            .output_size = latency[2],
+                                            .arrival_cycle = latency[3],
+                                            .first_token_cycle = latency[4],
+                                            .last_token_cycle = latency[5],
+                                            .completed_cycle = latency[6]});
+    }
+    _waiting_queue = {};
+    for (auto &request : j["waiting_queue"]) _waiting_queue.push(request_from_json(request));
+    RequestGenerator::row_index = j["row_index"];
+    rid = j["rid"];
+}
+
+uint32_t generate_rid() { return rid++; }
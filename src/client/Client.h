@@ -12,28 +12,51 @@ class Client {
    public:
     Client(SimulationConfig config);
     void cycle();
+    // event-driven clock skipping
+    cycle_type cycles_to_next_event();
+    void skip_cycles(cycle_type cycles) { _cycles += cycles; }
 
     bool running();
     bool has_request();
     std::shared_ptr<InferRequest> pop_request();
     void receive_response(std::shared_ptr<InferRequest> response);
+    // latency (TTFT, TPOT, end-to-end) of completed requests -> _latency.tsv, _latency.json
+    void print_stat();
+
+    // checkpoint (including the RequestGenerator cursor and request id counter)
+    void save_state(json &j);
+    void load_state(const json &j);
 
    private:
     SimulationConfig _config;
-    uint32_t _cycles;
-    uint32_t _last_request_cycle;
-    uint32_t _need_wait_cycles;
+    cycle_type _cycles;
+    cycle_type _last_request_cycle;
+    cycle_type _need_wait_cycles;
 
     uint32_t _total_cnt;
     uint32_t _issued_cnt;
     uint32_t _completed_cnt;
 
-    uint32_t _request_interval;  // send a request per (core_freq/qps) cycles
+    cycle_type _request_interval;  // send a request per (core_freq/qps) cycles
     std::queue<std::shared_ptr<InferRequest>> _waiting_queue;
+    // cycles from the last request to the next one (request_arrival)
+    cycle_type next_request_wait();
+
+    typedef struct {
+        uint32_t id;
+        uint32_t input_size;
+        uint32_t output_size;
+        cycle_type arrival_cycle;
+        cycle_type first_token_cycle;
+        cycle_type last_token_cycle;
+        cycle_type completed_cycle;
+    } RequestLatency;
+    std::vector<RequestLatency> _latencies;
+    double cycles_to_ms(double cycles);
 
-    /* Random generate from poisson disribution (request arrival time)*/
+    /* Poisson process: exponential inter-arrival times (request arrival time)*/
     std::mt19937 _gen;
-    std::poisson_distribution<> _distribution;
+    std::exponential_distribution<> _distribution;
 
     /* Random generate from uniform d (input, output size) [min, max)*/
     int _imin;
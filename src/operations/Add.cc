@@ -82,7 +82,7 @@ Tile Add::initialize_instructions(uint32_t N) {
         //     sram_activation_tmp_base + n_inner_offset * weight_count * _config.precision;
 
         // -- activation --
-        auto activation_addrs = activation_tensor0->get_row_addrs(n_outer_offset + n_inner_offset);
+        auto activation_addrs = activation_tensor0->get_row_addr_ranges(n_outer_offset + n_inner_offset);
         tile.instructions.push_back(Instruction{
             .opcode = Opcode::MOVIN,
             .dest_addr = sram_activation0_offset,
@@ -91,7 +91,7 @@ Tile Add::initialize_instructions(uint32_t N) {
             .operand_id = _INPUT_OPERAND,
         });
 
-        activation_addrs = activation_tensor1->get_row_addrs(n_outer_offset + n_inner_offset);
+        activation_addrs = activation_tensor1->get_row_addr_ranges(n_outer_offset + n_inner_offset);
         tile.instructions.push_back(Instruction{
             .opcode = Opcode::MOVIN,
             .dest_addr = sram_activation1_offset,
@@ -108,7 +108,7 @@ Tile Add::initialize_instructions(uint32_t N) {
             .src_addrs = std::vector<addr_type>{sram_activation0_offset, sram_activation1_offset},
         });
         // -- save outputs --
-        auto output_addrs = output_tensor->get_row_addrs(n_outer_offset + n_inner_offset);
+        auto output_addrs = output_tensor->get_row_addr_ranges(n_outer_offset + n_inner_offset);
         tile.instructions.push_back(Instruction{
             .opcode = Opcode::MOVOUT,
             .dest_addr = sram_accumulation_offset,
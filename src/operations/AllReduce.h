@@ -0,0 +1,27 @@
+#pragma once
+#include "../tensor/NPUTensor.h"
+#include "Operation.h"
+
+// All-reduce of a row-parallel partial sum (projection / FFN2 output) with the
+// other n_tp devices. The n_tp devices run the same sharded program, so only
+// this device is simulated and the others are modeled by the inter-device link
+// (see NeuPIMSystolicWS::get_allreduce_cycles).
+class AllReduce : public Operation {
+   public:
+    AllReduce(std::string name);
+
+    std::vector<Ptr<BTensor>> get_outputs(std::vector<Ptr<BTensor>> inputs);
+
+   private:
+    uint32_t _prod_batches;
+
+    std::vector<uint32_t> _input_dim;
+
+    std::vector<uint32_t> _inner_loop;
+    std::vector<uint32_t> _outer_loop;
+
+    void calculate_loops();
+    void initialize_tiles();
+    Tile initialize_instructions(uint32_t N);
+    uint32_t sram_size_needed();
+};
@@ -116,9 +116,9 @@ void FusedMHA::initialize_instructions(Tile &tile, int req_idx, int head_idx, in
         addr_type sram_l_ofs = sram_logit_base + h_ofs * (q_len * seq_len) * _config.precision;
         addr_type sram_acc_ofs = sram_accumulation_base + h_ofs * (q_len * _dk) * _config.precision;
 
-        std::vector<addr_type> dram_query_addrs;  // = _query[req_idx]->get_all_addrs();
-        std::vector<addr_type> dram_key_addrs;    // = _key[req_idx]->get_all_addrs();
-        std::vector<addr_type> dram_value_addrs;
+        AddrList dram_query_addrs;  // = _query[req_idx]->get_all_addrs();
+        AddrList dram_key_addrs;    // = _key[req_idx]->get_all_addrs();
+        AddrList dram_value_addrs;
 
         for (int i = 0; i < _dk; i++) {
             for (int seq_idx = 0; seq_idx < seq_len; seq_idx++) {
@@ -215,7 +215,7 @@ void FusedMHA::initialize_instructions(Tile &tile, int req_idx, int head_idx, in
             .size = q_len * _dk * _config.precision,
             .src_addrs = std::move(std::static_pointer_cast<NPUTensor>(_outputs[req_idx])
                                        ->_inners[h_idx]
-                                       ->get_all_addrs()),
+                                       ->get_addr_ranges()),
             .operand_id = _OUTPUT_OPERAND,
         });
     }
@@ -61,7 +61,7 @@ Tile Gelu::initialize_instructions(uint32_t N) {
         // n_inner_offset * weight_count * _config.precision;
 
         // -- activation --
-        auto activation_addrs = activation_tensor->get_row_addrs(n_outer_offset + n_inner_offset);
+        auto activation_addrs = activation_tensor->get_row_addr_ranges(n_outer_offset + n_inner_offset);
 
         tile.instructions.push_back(Instruction{
             .opcode = Opcode::MOVIN,
@@ -79,7 +79,7 @@ Tile Gelu::initialize_instructions(uint32_t N) {
             .src_addrs = std::vector<addr_type>{sram_activation_offset},
         });
         // -- save outputs --
-        auto output_addrs = output_tensor->get_row_addrs(n_outer_offset + n_inner_offset);
+        auto output_addrs = output_tensor->get_row_addr_ranges(n_outer_offset + n_inner_offset);
         tile.instructions.push_back(Instruction{
             .opcode = Opcode::MOVOUT,
             .dest_addr = sram_accumulation_offset,
@@ -127,7 +127,7 @@ Tile LayerNorm::initialize_instructions(uint32_t N) {
     auto beta_tensor = std::static_pointer_cast<NPUTensor>(_inputs[2]);
     // std::set<addr_type> beta_addrs =
     // beta_tensor->calculate_dram_addresses({});
-    std::vector<addr_type> beta_addrs = beta_tensor->get_all_addrs();
+    AddrList beta_addrs = beta_tensor->get_addr_ranges();
     tile.instructions.push_back(Instruction{
         .opcode = Opcode::MOVIN,
         .dest_addr = sram_beta_base,
@@ -140,7 +140,7 @@ Tile LayerNorm::initialize_instructions(uint32_t N) {
 
   // std::set<addr_type> gamma_addrs =
   // gamma_tensor->calculate_dram_addresses({});
-  std::vector<addr_type> gamma_addrs = gamma_tensor->get_all_addrs();
+  AddrList gamma_addrs = gamma_tensor->get_addr_ranges();
   tile.instructions.push_back(Instruction{
       .opcode = Opcode::MOVIN,
       .dest_addr = sram_gamma_base,
@@ -163,8 +163,8 @@ Tile LayerNorm::initialize_instructions(uint32_t N) {
 
     // -- activation --
     uint32_t row_idx = n_outer_offset + n_inner_offset;
-    std::vector<addr_type> activation_addrs =
-        activation_tensor->get_row_addrs(row_idx);
+    AddrList activation_addrs =
+        activation_tensor->get_row_addr_ranges(row_idx);
 
     if (activation_addrs.size() == 0)
       spdlog::info("zero load for activation m: {} {} / k: {} {} / "
@@ -188,8 +188,8 @@ Tile LayerNorm::initialize_instructions(uint32_t N) {
                                             sram_gamma_base, sram_beta_base},
     });
     // -- save outputs --
-    std::vector<addr_type> output_addrs =
-        output_tensor->get_row_addrs(n_outer_offset + n_inner_offset);
+    AddrList output_addrs =
+        output_tensor->get_row_addr_ranges(n_outer_offset + n_inner_offset);
     tile.instructions.push_back(Instruction{
         .opcode = Opcode::MOVOUT,
         .dest_addr = sram_accumulation_offset,
@@ -1,5 +1,7 @@
 #include "MatMul.h"
 
+#include "TileCache.h"
+
 // MatMul::MatMul(std::string name, std::vector<uint32_t> weight_dim) : Operation(name) {
 //     assert(weight_dim.size() == 2);
 //     _inputs.resize(3);
@@ -77,7 +79,10 @@ std::vector<Ptr<BTensor>> MatMul::get_outputs(std::vector<Ptr<BTensor>> inputs)
     // spdlog::info("[{}] input0 : {}  / input1: {}", _name, input0_dims, input1_dims);
 
     calculate_loops();
-    initialize_tiles();
+    if (!TileCache::GetInstance()->load(this)) {
+        initialize_tiles();
+        TileCache::GetInstance()->store(this);
+    }
 
     spdlog::info("input0 : {}  / input1: {} / output0 : {}", input0_dims, input1_dims, output_dims);
     spdlog::info("outer loop : {} / inner loop : {}", _outer_loop, _inner_loop);
@@ -164,7 +169,7 @@ Tile MatMul::initialize_instructions(uint32_t B, uint32_t M, uint32_t K, uint32_
         auto bias_tensor = std::static_pointer_cast<NPUTensor>(_inputs[2]);
         for (uint32_t n_inner_offset = 0; n_inner_offset < n_inner; n_inner_offset += loop_size) {
             // n_inner_offset: L1 tile start index in each L2 tile
-            std::vector<addr_type> bias_addrs;
+            AddrList bias_addrs;
             for (uint32_t n_loop = 0; n_loop < loop_size; ++n_loop) {
                 // get address by get_addr
                 auto bias_addr = bias_tensor->get_addr({n_outer_offset + n_inner_offset + n_loop});
@@ -215,7 +220,7 @@ Tile MatMul::initialize_instructions(uint32_t B, uint32_t M, uint32_t K, uint32_
                     tile_k = 0;
                     // During the n_inner tile iterations (to prevent duplication),
                     // add the MOVIN instruction only in the first inner loop.
-                    std::vector<addr_type> activation_addrs;
+                    AddrList activation_addrs;
                     for (int m_loop = 0; m_loop < loop_size; m_loop++) {
                         for (int k_loop = 0; k_loop < loop_size; k_loop++) {
                             std::vector<uint32_t> activation_indexes(batch_index);
@@ -261,7 +266,7 @@ Tile MatMul::initialize_instructions(uint32_t B, uint32_t M, uint32_t K, uint32_
                     tile_n = 0;
                     // During the m_inner tile iterations (to prevent duplication),
                     // add the MOVIN instruction only in the first inner loop.
-                    std::vector<addr_type> weight_addrs;
+                    AddrList weight_addrs;
                     for (int k_loop = 0; k_loop < loop_size; k_loop++) {
                         for (int n_loop = 0; n_loop < loop_size; n_loop++) {
                             std::vector<uint32_t> weight_indexes(batch_index);
@@ -331,7 +336,7 @@ Tile MatMul::initialize_instructions(uint32_t B, uint32_t M, uint32_t K, uint32_
                 // when iterating inner_loop k times,
                 // store L1 tile to output
                 if (should_store && (k_inner_offset + loop_size >= k_inner)) {
-                    std::vector<addr_type> output_addrs;
+                    AddrList output_addrs;
                     for (int n_loop = 0; n_loop < loop_size; n_loop++) {
                         for (int m_loop = 0; m_loop < loop_size; m_loop++) {
                             std::vector<uint32_t> output_indexes(batch_index);
@@ -398,14 +403,25 @@ void MatMul::calculate_loops() {
         _prod_batches *= larger_dims[i];
     }
 
-    while (sram_size_needed() > _config.spad_size KB / 2)  // double buffer
-    {
-        // max_element return iterator
-        // divide max_element dimension to 1/2,
-        // increment outer_loop to 1
-        auto max_el = max_element(_inner_loop.begin(), _inner_loop.end());
-        _outer_loop[max_el - _inner_loop.begin()] *= 2;
-        *max_el = ((*max_el) & 1) + ((*max_el) >> 1);  // ceil(*max_el / 2)
+    if (_config.gemm_mapping == GemmMapping::SEARCH) {
+        // (N, C) x (C, M) of the mapping is (M, K) x (K, N) here
+        auto &mapping = MappingSearch::GetInstance()->search(
+            _prod_batches,
+            Mapping::LoopCounts{.N = _inner_loop[0], .C = _inner_loop[1], .M = _inner_loop[2]},
+            _is_transposed);
+        _inner_loop = {mapping.tile_in_loop.N, mapping.tile_in_loop.C, mapping.tile_in_loop.M};
+        _outer_loop = {mapping.tile_out_loop.N, mapping.tile_out_loop.C,
+                       mapping.tile_out_loop.M};
+    } else {
+        while (sram_size_needed() > _config.spad_size KB / 2)  // double buffer
+        {
+            // max_element return iterator
+            // divide max_element dimension to 1/2,
+            // increment outer_loop to 1
+            auto max_el = max_element(_inner_loop.begin(), _inner_loop.end());
+            _outer_loop[max_el - _inner_loop.begin()] *= 2;
+            *max_el = ((*max_el) & 1) + ((*max_el) >> 1);  // ceil(*max_el / 2)
+        }
     }
 
     if (_is_transposed) {
@@ -139,8 +139,8 @@ Tile NeuPIMSAttend::initialize_instructions(int start, int end) {
       assert(logit->get_dims()[1] == seq_len);
 
       for (int h_idx = 0; h_idx < _nh; h_idx++) {
-        std::vector<addr_type> dram_logit_addrs;
-        std::vector<addr_type> dram_value_addrs;
+        AddrList dram_logit_addrs;
+        AddrList dram_value_addrs;
 
         for (int dk_idx = 0; dk_idx < _dk; dk_idx++) {
           for (int seq_idx = 0; seq_idx < seq_len; seq_idx++) {
@@ -198,7 +198,7 @@ Tile NeuPIMSAttend::initialize_instructions(int start, int end) {
             .size = sram_a_entry.second,
             .src_addrs = std::static_pointer_cast<NPUTensor>(_outputs[i])
                              ->_inners[h_idx]
-                             ->get_all_addrs(),
+                             ->get_addr_ranges(),
             .operand_id = _OUTPUT_OPERAND,
         });
       }
@@ -318,7 +318,7 @@ Tile NeuPIMSAttend::initialize_instructions(int start, int end) {
               .size = sram_acc_entry.second,
               .src_addrs = std::static_pointer_cast<NPUTensor>(_outputs[i])
                                ->_inners[hi]
-                               ->get_all_addrs(),
+                               ->get_addr_ranges(),
               .operand_id = _OUTPUT_OPERAND,
           });
         }
@@ -101,8 +101,8 @@ Tile NeuPIMSLogitSoftmax::initialize_instructions(int start, int end) {
             assert(seq_len == key->get_dims()[2]);
 
             for (int h_idx = 0; h_idx < _nh; h_idx++) {
-                std::vector<addr_type> dram_query_addrs;
-                std::vector<addr_type> dram_key_addrs;
+                AddrList dram_query_addrs;
+                AddrList dram_key_addrs;
 
                 for (int dk_idx = 0; dk_idx < _dk; dk_idx++) {
                     for (int seq_idx = 0; seq_idx < seq_len; seq_idx++) {
@@ -162,7 +162,7 @@ Tile NeuPIMSLogitSoftmax::initialize_instructions(int start, int end) {
                     .size = sram_ls_entry.second,
                     .src_addrs = std::static_pointer_cast<NPUTensor>(_outputs[i])
                                      ->_inners[h_idx]
-                                     ->get_all_addrs(),
+                                     ->get_addr_ranges(),
                     .operand_id = _OUTPUT_OPERAND,
                 });
             }
@@ -293,7 +293,7 @@ Tile NeuPIMSLogitSoftmax::initialize_instructions(int start, int end) {
                 .size = sram_acc_entry.second,
                 .src_addrs = std::static_pointer_cast<NPUTensor>(_outputs[i])
                                  ->_inners[hi]
-                                 ->get_all_addrs(),  // TODO:
+                                 ->get_addr_ranges(),  // TODO:
                 .operand_id = _OUTPUT_OPERAND,
             });
             counter_for_debug++;
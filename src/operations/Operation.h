@@ -86,6 +86,7 @@ class Operation : public std::enable_shared_from_this<Operation> {
 
     bool _finish;
     friend Model;
+    friend class TileCache;
     addr_type _spad_addr;
     addr_type _acc_spad_addr;
 
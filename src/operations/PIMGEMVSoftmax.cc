@@ -202,7 +202,7 @@ Tile PIMGEMVSoftmax::initialize_instructions() {
                 .size = column_height * _config.precision,
                 .src_addrs = std::static_pointer_cast<NPUTensor>(_outputs[i])
                                  ->_inners[hi]
-                                 ->get_all_addrs(),  // TODO:
+                                 ->get_addr_ranges(),  // TODO:
                 .operand_id = _OUTPUT_OPERAND,
             });
             sram_acc_base += column_height * _config.precision;
@@ -82,7 +82,7 @@ Tile Softmax::initialize_instructions(uint32_t N, uint32_t req_idx) {
         // n_inner_offset * weight_count * _config.precision;
 
         // -- activation --
-        auto activation_addrs = activation_tensor->get_row_addrs(n_outer_offset + n_inner_offset);
+        auto activation_addrs = activation_tensor->get_row_addr_ranges(n_outer_offset + n_inner_offset);
 
         spdlog::info("Softmax act_addrs.size(): {}", activation_addrs.size());
 
@@ -102,7 +102,7 @@ Tile Softmax::initialize_instructions(uint32_t N, uint32_t req_idx) {
             .src_addrs = std::vector<addr_type>{sram_activation_offset},
         });
         // -- save outputs --
-        auto output_addrs = output_tensor->get_row_addrs(n_outer_offset + n_inner_offset);
+        auto output_addrs = output_tensor->get_row_addr_ranges(n_outer_offset + n_inner_offset);
         tile.instructions.push_back(Instruction{
             .opcode = Opcode::MOVOUT,
             .dest_addr = sram_accumulation_offset,
@@ -0,0 +1,116 @@
+#include "TileCache.h"
+
+bool TileCache::make_key(Operation *op, std::string &key, std::vector<ActRange> &act_ranges) {
+    key = op->_name;
+
+    std::vector<Ptr<BTensor>> tensors(op->_inputs);
+    tensors.insert(tensors.end(), op->_outputs.begin(), op->_outputs.end());
+    for (auto btensor : tensors) {
+        auto tensor = std::dynamic_pointer_cast<NPUTensor>(btensor);
+        if (tensor == nullptr) return false;
+
+        key += "|";
+        for (auto dim : tensor->get_dims()) key += std::to_string(dim) + ",";
+        for (auto inner : tensor->_inners) {
+            // KV tensors are not contiguous
+            if (std::dynamic_pointer_cast<NPUTensor2D>(inner) == nullptr) return false;
+
+            if (inner->_buf_type == NPUTensorBufType::WGT) {
+                key += "w" + std::to_string(inner->_base_addr) + ",";
+            } else if (inner->_buf_type == NPUTensorBufType::ACT && inner->_dims.size() == 2) {
+                // 1D addresses (bias) are not switched, so only 2D activations are rebased
+                act_ranges.push_back(ActRange{inner->_base_addr, inner->_size});
+            } else {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void TileCache::rebase(addr_type &addr, const std::vector<ActRange> &from,
+                       const std::vector<ActRange> &to) {
+    addr_type raw_addr = AddressConfig::unswitch_co_ch(addr);
+    for (size_t i = 0; i < from.size(); i++) {
+        if (raw_addr >= from[i].base_addr && raw_addr < from[i].base_addr + from[i].size) {
+            addr = AddressConfig::switch_co_ch(raw_addr - from[i].base_addr + to[i].base_addr);
+            return;
+        }
+    }
+}
+
+// A run inside one aligned block stays contiguous under switch_co_ch (it only moves
+// bits above the alignment) and the activation bases are aligned, so the run moves
+// as a whole. Runs across blocks are rebased address by address.
+AddrList TileCache::rebase_addrs(const AddrList &addrs, const std::vector<ActRange> &from,
+                                 const std::vector<ActRange> &to) {
+    AddrList ret;
+    for (auto &range : addrs.ranges()) {
+        addr_type first = range.base;
+        addr_type last = range.base + range.stride * (range.count - 1);
+        addr_type new_first = first;
+        addr_type new_last = last;
+        rebase(new_first, from, to);
+        rebase(new_last, from, to);
+        if (AddressConfig::align(first) == AddressConfig::align(last) &&
+            new_last - new_first == last - first) {
+            ret.push_range(new_first, range.stride, range.count);
+            continue;
+        }
+        for (uint32_t i = 0; i < range.count; i++) {
+            addr_type addr = range.base + range.stride * i;
+            rebase(addr, from, to);
+            ret.push_back(addr);
+        }
+    }
+    return ret;
+}
+
+bool TileCache::load(Operation *op) {
+    if (Config::global_config.tile_cache_size == 0) return false;
+
+    std::string key;
+    std::vector<ActRange> act_ranges;
+    if (!make_key(op, key, act_ranges)) return false;
+
+    auto it = _entries.find(key);
+    if (it == _entries.end()) {
+        _misses++;
+        return false;
+    }
+    _hits++;
+
+    Entry &entry = it->second;
+    ast(entry.act_ranges.size() == act_ranges.size());
+    bool moved = false;
+    for (size_t i = 0; i < act_ranges.size(); i++)
+        moved = moved || entry.act_ranges[i].base_addr != act_ranges[i].base_addr;
+
+    op->_tiles = entry.tiles;
+    for (auto &tile : op->_tiles) {
+        tile.operation_id = op->_id;
+        if (!moved) continue;
+        for (auto &inst : tile.instructions) {
+            if (inst.opcode != Opcode::MOVIN && inst.opcode != Opcode::MOVOUT) continue;
+            inst.src_addrs = rebase_addrs(inst.src_addrs, entry.act_ranges, act_ranges);
+        }
+    }
+    return true;
+}
+
+void TileCache::store(Operation *op) {
+    uint32_t capacity = Config::global_config.tile_cache_size;
+    if (capacity == 0) return;
+
+    std::string key;
+    std::vector<ActRange> act_ranges;
+    if (!make_key(op, key, act_ranges)) return;
+    if (_entries.find(key) != _entries.end()) return;
+
+    if (_entries.size() >= capacity) {
+        _entries.erase(_insert_order.front());
+        _insert_order.pop_front();
+    }
+    _entries[key] = Entry{op->_tiles, act_ranges};
+    _insert_order.push_back(key);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "../Common.h"
+#include "../tensor/NPUTensor.h"
+#include "Operation.h"
+
+/**
+ * TileCache: reuse of generated tiles across StagePrograms
+ *  Every stage builds new StagePrograms, and the operations of the same layer
+ *  generate the same instruction streams again (e.g. QKVGen in Stage A, B, D).
+ *  Tiles are cached by operation name, tensor shapes and weight addresses.
+ *  Activation tensors are allocated at a different address in each program, so
+ *  on a hit the DRAM addresses of the cached activation tensors are rebased to
+ *  the new ones instead of regenerating every address.
+ *
+ *  Only operations whose operands are all NPUTensor2D (weight or activation)
+ *  are cached. Capacity is tile_cache_size operations, 0 disables it.
+ */
+class TileCache : public Singleton<TileCache> {
+   private:
+    friend class Singleton;
+    TileCache() : _hits(0), _misses(0) {}
+    ~TileCache() = default;
+
+   public:
+    // restore op->_tiles from the cache. false if the op has to generate them
+    bool load(Operation *op);
+    void store(Operation *op);
+
+    uint64_t get_hits() { return _hits; }
+    uint64_t get_misses() { return _misses; }
+
+   private:
+    struct ActRange {
+        addr_type base_addr;
+        uint64_t size;
+    };
+    struct Entry {
+        std::deque<Tile> tiles;
+        std::vector<ActRange> act_ranges;
+    };
+
+    bool make_key(Operation *op, std::string &key, std::vector<ActRange> &act_ranges);
+    void rebase(addr_type &addr, const std::vector<ActRange> &from,
+                const std::vector<ActRange> &to);
+    AddrList rebase_addrs(const AddrList &addrs, const std::vector<ActRange> &from,
+                          const std::vector<ActRange> &to);
+
+    robin_hood::unordered_map<std::string, Entry> _entries;
+    std::deque<std::string> _insert_order;  // FIFO eviction
+
+    uint64_t _hits;
+    uint64_t _misses;
+};
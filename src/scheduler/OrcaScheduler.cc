@@ -1,9 +1,182 @@
 #include "OrcaScheduler.h"
 
 OrcaScheduler::OrcaScheduler(SimulationConfig config, const cycle_type *core_cycle)
-    : Scheduler(config, core_cycle) {
-    // [ ] init max_active_reqs from config. memory capacity
-    spdlog::info("OrcaScheduler init");
+    : Scheduler(config, core_cycle), _iteration_start_cycle(0), _iteration_prefills(0) {
+    if (_config.continuous_batching) {
+        _max_batch_size = config.max_batch_size;
+        _max_active_reqs = config.max_active_reqs;
+    }
+    spdlog::info("OrcaScheduler init (continuous batching: {})", _config.continuous_batching);
 }
 
-void OrcaScheduler::cycle() { Scheduler::cycle(); }
+void OrcaScheduler::cycle() {
+    if (!_config.continuous_batching) {
+        Scheduler::cycle();
+        return;
+    }
+
+    if (iteration_done()) schedule_iteration();
+
+    _cycles++;
+
+    bool lets_make_program = _model_program1 == nullptr && _model_program2 == nullptr &&
+                             _stage != Stage::Finish && (_breq1.size() > 0 || _breq2.size() > 0);
+    if (lets_make_program) {
+        std::string red = "\033[1;31m";
+        std::string reset = "\033[0m";
+        spdlog::info("{}----------Stage {}----------{}", red, stageToString(_stage), reset);
+        make_program();
+    }
+}
+
+// the last stage of the batch is done, or requests are waiting for an empty batch
+bool OrcaScheduler::iteration_done() {
+    bool idle = _model_program1 == nullptr && _model_program2 == nullptr;
+    bool empty_batch = _breq1.empty() && _breq2.empty();
+    return idle && (_stage == Stage::Finish || (empty_batch && !_request_queue.empty()));
+}
+
+void OrcaScheduler::schedule_iteration() {
+    if (_stage == Stage::Finish) retire_iteration();
+
+    // join: newly allocated requests run their prompt in this iteration
+    std::vector<Ptr<InferRequest>> waiting;
+    for (auto &request : _request_queue) {
+        if (request->K_cache.empty()) waiting.push_back(request);
+    }
+    allocate_requests();
+    _iteration_prefills = 0;
+    for (auto &request : waiting) {
+        if (request->K_cache.empty()) continue;
+        request->is_initiated = false;
+        _iteration_prefills++;
+    }
+
+    _breq1.clear();
+    _breq2.clear();
+    group_sub_batches();
+    _stage = _init_stage;
+    _iteration_start_cycle = _cycles;
+
+    if (_breq1.size() + _breq2.size() > 0) {
+        spdlog::info("Iteration {}: {} requests ({} prefill), {} waiting", _iteration_stats.size(),
+                     _breq1.size() + _breq2.size(), _iteration_prefills,
+                     _request_queue.size() - _active_reqs);
+    }
+}
+
+// leave: every request in the batch generated a token
+void OrcaScheduler::retire_iteration() {
+    std::vector<Ptr<InferRequest>> batch(_breq1);
+    batch.insert(batch.end(), _breq2.begin(), _breq2.end());
+    _iteration_stats.push_back(IterationStat{
+        .start_cycle = _iteration_start_cycle,
+        .end_cycle = _cycles,
+        .num_reqs = (uint32_t)batch.size(),
+        .num_prefills = _iteration_prefills,
+    });
+
+    cleanup_sub_batch(_breq1);
+    cleanup_sub_batch(_breq2);
+    for (auto &request : batch) {
+        if (request->generated == request->output_size) {
+            release_request(request);
+        } else {
+            // K/V of the generated token
+            request->K_cache[0]->add_token();
+            request->V_cache[0]->add_token();
+        }
+    }
+}
+
+// KV cache blocks are already freed by cleanup_sub_batch
+void OrcaScheduler::release_request(Ptr<InferRequest> request) {
+    uint32_t ch = request->channel;
+
+    auto &req_queue = _active_request_queues[ch];
+    auto it = std::find(req_queue.begin(), req_queue.end(), request);
+    ast(it != req_queue.end());
+    int idx = it - req_queue.begin();
+    _active_request_accum_latencys[ch] -= _active_request_latency_queues[ch][idx];
+    _active_request_latency_queues[ch].erase(_active_request_latency_queues[ch].begin() + idx);
+    req_queue.erase(it);
+}
+
+cycle_type OrcaScheduler::cycles_to_next_event() {
+    if (!_config.continuous_batching) return Scheduler::cycles_to_next_event();
+
+    if (_has_stage_changed || !_completed_request_queue.empty() || iteration_done()) return 0;
+
+    bool idle = _model_program1 == nullptr && _model_program2 == nullptr;
+    if (idle && _stage != Stage::Finish && (_breq1.size() > 0 || _breq2.size() > 0)) return 0;
+
+    return std::numeric_limits<cycle_type>::max();
+}
+
+/**
+ * Throughput of continuous batching
+ *  Every request in an iteration generates a token. Steady state excludes the
+ *  ramp-up and drain of the batch: iterations with at least half of the peak
+ *  batch size.
+ */
+void OrcaScheduler::print_stat() {
+    Scheduler::print_stat();
+    if (!_config.continuous_batching || _iteration_stats.empty()) return;
+
+    std::string fname = _config.log_dir + "/_iterations.tsv";
+    std::ofstream ofile(fname);
+    ast(ofile.is_open());
+    ofile << "iteration\tstart_cycle\tend_cycle\tnum_reqs\tnum_prefills\t\n";
+
+    uint32_t peak_reqs = 0;
+    for (auto &stat : _iteration_stats) peak_reqs = MAX(peak_reqs, stat.num_reqs);
+
+    uint64_t tokens = 0, steady_tokens = 0;
+    uint64_t steady_cycles = 0, steady_iterations = 0;
+    for (size_t i = 0; i < _iteration_stats.size(); i++) {
+        auto &stat = _iteration_stats[i];
+        ofile << i << "\t" << stat.start_cycle << "\t" << stat.end_cycle << "\t" << stat.num_reqs
+              << "\t" << stat.num_prefills << "\t\n";
+
+        tokens += stat.num_reqs;
+        if (stat.num_reqs * 2 >= peak_reqs) {
+            steady_tokens += stat.num_reqs;
+            steady_cycles += stat.end_cycle - stat.start_cycle;
+            steady_iterations++;
+        }
+    }
+    ofile.close();
+
+    double cycles_per_sec = (double)_config.core_freq * 1e6;  // core_freq in MHz
+    uint64_t total_cycles = _iteration_stats.back().end_cycle;
+    spdlog::info("Continuous batching: {} iterations, {} tokens, {:.2f} tokens/s",
+                 _iteration_stats.size(), tokens, tokens * cycles_per_sec / total_cycles);
+    spdlog::info("Steady state ({} iterations, batch >= {}): {:.2f} tokens/s", steady_iterations,
+                 (peak_reqs + 1) / 2, steady_tokens * cycles_per_sec / steady_cycles);
+}
+
+void OrcaScheduler::save_state(json &j) {
+    Scheduler::save_state(j);
+    j["iteration_stats"] = json::array();
+    for (auto &stat : _iteration_stats) {
+        j["iteration_stats"].push_back(
+            {stat.start_cycle, stat.end_cycle, stat.num_reqs, stat.num_prefills});
+    }
+    j["iteration_start_cycle"] = _iteration_start_cycle;
+    j["iteration_prefills"] = _iteration_prefills;
+}
+
+void OrcaScheduler::load_state(const json &j) {
+    Scheduler::load_state(j);
+    _iteration_stats.clear();
+    for (auto &stat : j["iteration_stats"]) {
+        _iteration_stats.push_back(IterationStat{
+            .start_cycle = stat[0],
+            .end_cycle = stat[1],
+            .num_reqs = stat[2],
+            .num_prefills = stat[3],
+        });
+    }
+    _iteration_start_cycle = j["iteration_start_cycle"];
+    _iteration_prefills = j["iteration_prefills"];
+}
@@ -1,11 +1,38 @@
 #pragma once
 #include "Scheduler.h"
 
+/**
+ * OrcaScheduler: iteration-level (continuous) batching
+ *  With continuous_batching, a stage sequence (A~F) is one iteration of the
+ *  current batch. At every iteration boundary finished requests leave the batch
+ *  and release their KV cache rows, and waiting requests join it. A request
+ *  runs its prompt (prefill) in its first iteration and one token afterwards.
+ *  Otherwise it is the same as Scheduler (a single batch from stage A).
+ */
 class OrcaScheduler : public Scheduler {
    public:
     OrcaScheduler(SimulationConfig config, const cycle_type *core_cycle);
     void cycle() override;
+    cycle_type cycles_to_next_event() override;
+    void print_stat() override;
+
+    void save_state(json &j) override;
+    void load_state(const json &j) override;
 
    private:
-    uint32_t _max_active_reqs;
+    typedef struct {
+        uint32_t start_cycle;
+        uint32_t end_cycle;
+        uint32_t num_reqs;      // = generated tokens
+        uint32_t num_prefills;  // requests in prefill
+    } IterationStat;
+
+    void schedule_iteration();
+    void retire_iteration();
+    void release_request(Ptr<InferRequest> request);
+    bool iteration_done();
+
+    std::vector<IterationStat> _iteration_stats;
+    uint32_t _iteration_start_cycle;
+    uint32_t _iteration_prefills;
 };
@@ -2,6 +2,8 @@
 
 #include <cmath>
 
+#include "../BatchedRequest.h"
+#include "../Tracer.h"
 #include "../tensor/NPUTensor.h"
 #include "../tensor/PIMTensor.h"
 
@@ -10,8 +12,18 @@ Scheduler::Scheduler(SimulationConfig config, const cycle_type *core_cycle)
   _max_batch_size = 1024;  // 256;   // config.max_batch_size;
   _max_active_reqs = 1024; // 256;  // 70;
   _active_reqs = 0;
+  _channel_placement = config.channel_placement;
   _next_ch = 0;
-  _ch_load_balancing = config.ch_load_balancing;
+  _placed_requests.resize(config.dram_channels, 0);
+  _placed_latency.resize(config.dram_channels, 0);
+  _placement_failures = 0;
+
+  _tile_dispatch = config.tile_dispatch;
+  _n_cores = config.num_cores;
+  _next_core1 = 0;
+  _next_core2 = 0;
+  _core_loads.resize(_n_cores, 0);
+  _dispatched_tiles.resize(_n_cores, 0);
 
   // Model dimension init
   _nh = _config.model_n_head / _config.n_tp;
@@ -36,6 +48,8 @@ Scheduler::Scheduler(SimulationConfig config, const cycle_type *core_cycle)
   _just_one_stage = false; // 调试用标志：是否只运行一个阶段
 
   _has_stage_changed = false;
+  _fast_forward_layers = 0;
+  _pp_iteration_start = 0;
 
   _partition_alg_simple =
       true; // 默认使用简单的对半切分算法进行子批次划分 false使用动态规划的方法
@@ -53,7 +67,8 @@ Scheduler::Scheduler(SimulationConfig config, const cycle_type *core_cycle)
 
   // KV allocate by pim tile
   int model_weight =
-      _config.model_params_b * _config.precision / _config.n_tp;   // GB
+      _config.model_params_b * _config.precision / _config.n_tp /
+      _config.n_pp;                                                // GB
   int memory_capacity = _dram_channels;                            // GB
   int available_for_kv = memory_capacity - model_weight;           // GB
   int pim_tile_size = _config.dram_page_size * _dram_banks_per_ch; // B
@@ -94,98 +109,127 @@ void Scheduler::launch(Ptr<Model> model) {
   spdlog::info("MODEL {} Launched in Scheduler", model->get_name());
 }
 
-/* Deprecated: allocate channel when making dataset */
-// if return -1, it means there is no available tile for this request
-int Scheduler::allocate_pim_tile(uint32_t seq_len) {
-  // granularity of key
-  // granularity of value
-
-  int key_pages = ceil((double)seq_len / _key_period);
-  int value_pages = ceil((double)seq_len / _value_period);
+// PIM tiles of the KV cache at the last token of the request
+uint32_t Scheduler::required_pim_tiles(Ptr<InferRequest> request) {
+  uint32_t seq_len = request->input_size + request->output_size;
+  uint32_t key_pages = ceil((double)seq_len / _key_period);
+  uint32_t value_pages = ceil((double)seq_len / _value_period);
+  return key_pages * _key_page_size + value_pages * _value_page_size;
+}
 
-  int key_tiles = key_pages * _key_page_size;
-  int value_tiles = value_pages * _value_page_size;
-  int required_tiles_for_kv_cache = key_tiles + value_tiles;
+// channel with the least accumulated MHA latency among those with enough tiles
+// if return -1, it means there is no available tile for this request
+int Scheduler::least_latency_channel(
+    uint32_t tiles, const std::vector<uint32_t> &available_tiles,
+    const std::vector<uint32_t> &accum_latencys) {
+  int ch = -1;
+  for (int i = 0; i < _dram_channels; i++) {
+    if (available_tiles[i] < tiles)
+      continue;
+    if (ch == -1 || accum_latencys[i] < accum_latencys[ch])
+      ch = i;
+  }
+  return ch;
+}
 
-  uint32_t ch;
+// lookahead: requests admitted by this allocate_requests() are placed together,
+// longest MHA first, each on the channel with the least latency (LPT). A request
+// arriving alone is placed as min_latency.
+void Scheduler::plan_lookahead() {
+  _planned_channels.clear();
+  uint32_t slots = _max_active_reqs - MIN(_active_reqs, _max_active_reqs);
+  std::vector<std::pair<uint32_t, Ptr<InferRequest>>> window;
+  for (auto &request : _request_queue) {
+    if (window.size() == slots)
+      break;
+    if (!request->is_initiated && request->channel == -1)
+      window.push_back({estimate_mha_latency(request), request});
+  }
+  std::stable_sort(window.begin(), window.end(),
+                   [](const auto &a, const auto &b) { return a.first > b.first; });
+
+  auto available_tiles = _available_tiles;
+  auto accum_latencys = _active_request_accum_latencys;
+  for (auto &[latency, request] : window) {
+    uint32_t tiles = required_pim_tiles(request);
+    int ch = least_latency_channel(tiles, available_tiles, accum_latencys);
+    if (ch == -1)
+      continue;
+    available_tiles[ch] -= tiles;
+    accum_latencys[ch] += latency;
+    _planned_channels[request->id] = ch;
+  }
+}
 
-  if (_ch_load_balancing) {
-    // >> neupims: channel load balancing
-    // greedy algorithm
-    ch = -1;
-    int min_latency = 2147483647;
+// if return -1, it means there is no available tile for this request
+int Scheduler::place_request(Ptr<InferRequest> request) {
+  uint32_t tiles = required_pim_tiles(request);
+  int ch = -1;
+  switch (_channel_placement) {
+  case ChannelPlacement::ROUND_ROBIN:
+    for (uint32_t trial = 0; trial < _dram_channels; trial++) {
+      uint32_t next = (_next_ch + trial) % _dram_channels;
+      if (_available_tiles[next] >= tiles) {
+        ch = next;
+        break;
+      }
+    }
+    if (ch != -1)
+      _next_ch = (ch + 1) % _dram_channels;
+    break;
+  case ChannelPlacement::CAPACITY:
     for (int i = 0; i < _dram_channels; i++) {
-      int available_tiles = _available_tiles[i];
-      int accum_latency = _active_request_accum_latencys[i];
-      if (available_tiles < required_tiles_for_kv_cache)
+      if (_available_tiles[i] < tiles)
         continue;
-
-      // Find most lazy channel (min total latency)
-      if (min_latency > accum_latency) {
-        min_latency = accum_latency;
+      if (ch == -1 || _available_tiles[i] > _available_tiles[ch] ||
+          (_available_tiles[i] == _available_tiles[ch] &&
+           _active_request_accum_latencys[i] <
+               _active_request_accum_latencys[ch]))
         ch = i;
-      }
-    }
-    if (ch == -1) {
-      spdlog::info("No available tiles for this request");
-      return -1;
-    } else {
-      // push to channel that is min (sum of requests latency) among channels
-      _available_tiles[ch] -= required_tiles_for_kv_cache;
-    }
-
-  } else {
-    // >> newton: round-robin channel allocate
-    ch = _next_ch % _dram_channels;
-    int available_tiles = _available_tiles[ch];
-    if (available_tiles >= required_tiles_for_kv_cache) {
-      _available_tiles[ch] -= required_tiles_for_kv_cache;
-    } else {
-      int trial = _dram_channels;
-      while (trial--) {
-        ch = _next_ch % _dram_channels;
-        available_tiles = _available_tiles[ch];
-        if (available_tiles >= required_tiles_for_kv_cache) {
-          _available_tiles[ch] -= required_tiles_for_kv_cache;
-          break;
-        }
-        ch = -1;
-        _next_ch++;
-      }
-    }
-    if (ch == -1) {
-      spdlog::info("No available tiles for this request");
-      return -1;
     }
-    _next_ch++;
+    break;
+  case ChannelPlacement::LOOKAHEAD: {
+    auto it = _planned_channels.find(request->id);
+    if (it != _planned_channels.end() && _available_tiles[it->second] >= tiles)
+      ch = it->second;
+    if (ch != -1)
+      break;
+    ch = least_latency_channel(tiles, _available_tiles,
+                               _active_request_accum_latencys);
+    break;
+  }
+  default:
+    ch = least_latency_channel(tiles, _available_tiles,
+                               _active_request_accum_latencys);
+    break;
   }
 
-  assert(ch != -1);
-  // spdlog::info("seqlen: {}", seq_len);
-  // spdlog::info("required Key pages: {}", key_pages);
-  // spdlog::info("required Value pages: {}", value_pages);
-  // spdlog::info("required KV tiles: {}", required_tiles_for_kv_cache);
-
-  _total_available_tiles -= required_tiles_for_kv_cache;
-  // spdlog::info("Remain tiles: {}", _total_available_tiles);
-  // spdlog::info("Remain tiles in ch#{}: {}", ch, _available_tiles[ch]);
-  // spdlog::info("--------------------");
+  if (ch == -1) {
+    spdlog::info("No available tiles for request#{} ({} tiles)", request->id,
+                 tiles);
+    _placement_failures++;
+    return -1;
+  }
+  _available_tiles[ch] -= tiles;
+  _total_available_tiles -= tiles;
+  _placed_requests[ch]++;
+  _placed_latency[ch] += estimate_mha_latency(request);
   return ch;
 }
 
+void Scheduler::release_pim_tiles(Ptr<InferRequest> request) {
+  if (_channel_placement == ChannelPlacement::TRACE || request->channel == -1)
+    return;
+  uint32_t tiles = required_pim_tiles(request);
+  _available_tiles[request->channel] += tiles;
+  _total_available_tiles += tiles;
+}
+
 void Scheduler::allocate_requests() {
   uint32_t batch_size = 0;
 
-  // if (_ch_load_balancing) {
-  //     // sort request_queue by sequence length
-  //     // for channel load balancing algorithm
-  //     // greedy algorithm
-  //     std::sort(_request_queue.begin(), _request_queue.end(),
-  //               [this](const Ptr<InferRequest>& a, const Ptr<InferRequest>&
-  //               b) {
-  //                   return compare_by_seqlen(a, b);
-  //               });
-  // }
+  if (_channel_placement == ChannelPlacement::LOOKAHEAD)
+    plan_lookahead();
   for (auto it = _request_queue.begin(); it != _request_queue.end();
        it++) { //遍历请求队列
     if (batch_size == _max_batch_size)
@@ -194,23 +238,25 @@ void Scheduler::allocate_requests() {
     assert(request->output_size > request->generated);
 
     if (!request->is_initiated) { //判断该请求是否是第一次被调度器处理
-      int ch =
-          request
-              ->channel; //调用之前python脚本已经生成的请求trace文件里面分配的channel
-      assert(ch < _dram_channels);
+      if (_active_reqs >= _max_active_reqs)
+        continue;
+      // trace: 调用之前python脚本已经生成的请求trace文件里面分配的channel
+      // otherwise: 在线放置到有足够 PIM tile 的通道
+      int ch = _channel_placement == ChannelPlacement::TRACE
+                   ? request->channel
+                   : place_request(request);
       spdlog::info("request#{} seq_len:{} channel:{}", request->id,
-                   request->input_size, request->channel);
-      // allocate_pim_tile(request->input_size);
+                   request->input_size, ch);
       if (ch == -1)
         continue;
+      assert(ch < (int)_dram_channels);
+      request->channel = ch;
 
       uint32_t seq_len = request->input_size;
 
       std::vector<uint32_t> dim_key{_nh, _dk, seq_len};
       std::vector<uint32_t> dim_value{_nh, seq_len, _dk};
 
-      if (_active_reqs >= _max_active_reqs)
-        continue;
       _active_reqs++; //限制并发请求数量 目前并发请求=max_batch_size
       // spdlog::info("Scheduler allocate request#{}(seq_len:{}) to channel
       // {}<<",
@@ -281,6 +327,9 @@ void Scheduler::make_program() {
   spdlog::info("New Program for PIM (sub-batch.size: {})",
                sub_batch_on_pim->_reqs.size());
 
+  if (_stage == _init_stage)
+    _pp_iteration_start = _cycles;
+
   _model_program1 = std::make_unique<StageProgram>(_model, sub_batch_on_sa,
                                                    StagePlatform::SA, _stage);
   _model_program2 = std::make_unique<StageProgram>(_model, sub_batch_on_pim,
@@ -469,6 +518,29 @@ void Scheduler::cycle() {
   }
 }
 
+// 0 if cycle() has something to do. otherwise the scheduler just waits for
+// tiles to finish, which is an event of cores.
+cycle_type Scheduler::cycles_to_next_event() {
+  if (_has_stage_changed || !_completed_request_queue.empty())
+    return 0;
+
+  bool step_next_stage =
+      _model_program1 == nullptr && _model_program2 == nullptr;
+  if (step_next_stage && _stage == _init_stage && !_request_queue.empty())
+    return 0;
+
+  bool make_program;
+  if (_config.sub_batch_mode)
+    make_program = _model_program1 == nullptr && _breq1.size() > 0 &&
+                   _model_program2 == nullptr && _breq2.size() > 0;
+  else
+    make_program = step_next_stage && (_breq1.size() > 0 || _breq2.size() > 0);
+  if (make_program)
+    return 0;
+
+  return std::numeric_limits<cycle_type>::max();
+}
+
 void Scheduler::add_request(std::shared_ptr<InferRequest> request) {
   _request_queue.push_back(request);
 }
@@ -490,7 +562,8 @@ Tile &Scheduler::top_tile1(uint32_t core_id) {
     return empty_tile;
   } else {
     Tile &tile = _executable_tile_queue1.front();
-    if (tile.status == Tile::Status::BAR) {
+    if (tile.status == Tile::Status::BAR ||
+        dispatch_core(tile, _next_core1) != core_id) {
       return empty_tile;
     } else {
       tile.stage_platform = StagePlatform::SA;
@@ -505,7 +578,8 @@ Tile &Scheduler::top_tile2(uint32_t core_id) {
     return empty_tile;
   } else {
     Tile &tile = _executable_tile_queue2.front();
-    if (tile.status == Tile::Status::BAR) {
+    if (tile.status == Tile::Status::BAR ||
+        dispatch_core(tile, _next_core2) != core_id) {
       return empty_tile;
     } else {
       tile.stage_platform = StagePlatform::PIM;
@@ -532,6 +606,7 @@ void Scheduler::get_tile1(uint32_t core_id) {
       return;
     } else {
       _active_operation_stats[tile.operation_id].launched_tiles++;
+      dispatch_tile(core_id, _next_core1);
       _executable_tile_queue1.pop_front();
       spdlog::debug("Operation {} Core {} Get Tile at {}", tile.optype, core_id,
                     *_core_cycle);
@@ -555,6 +630,7 @@ void Scheduler::get_tile2(uint32_t core_id) {
       return;
     } else {
       _active_operation_stats[tile.operation_id].launched_tiles++;
+      dispatch_tile(core_id, _next_core2);
       _executable_tile_queue2.pop_front();
       spdlog::debug("Operation {} Core {} Get Tile at {}", tile.optype, core_id,
                     *_core_cycle);
@@ -563,6 +639,37 @@ void Scheduler::get_tile2(uint32_t core_id) {
   }
 }
 
+// core that may take the head tile of a queue
+uint32_t Scheduler::dispatch_core(Tile &tile, uint32_t next_core) {
+  if (_n_cores == 1)
+    return 0;
+
+  switch (_tile_dispatch) {
+  case TileDispatch::LEAST_LOADED:
+    return std::min_element(_core_loads.begin(), _core_loads.end()) -
+           _core_loads.begin();
+  case TileDispatch::CHANNEL_AFFINITY:
+    // channels are split into _n_cores contiguous groups
+    for (auto &inst : tile.instructions) {
+      if (inst.src_addrs.empty())
+        continue;
+      if (inst.opcode == Opcode::MOVIN || inst.opcode == Opcode::PIM_HEADER) {
+        uint32_t ch = AddressConfig::mask_channel(inst.src_addrs.front());
+        return ch * _n_cores / _dram_channels;
+      }
+    }
+    return next_core;
+  default:
+    return next_core;
+  }
+}
+
+void Scheduler::dispatch_tile(uint32_t core_id, uint32_t &next_core) {
+  _core_loads[core_id]++;
+  _dispatched_tiles[core_id]++;
+  next_core = (core_id + 1) % _n_cores;
+}
+
 //  update operation stat
 //  if operation is finished
 //      apply to _model_program & return true
@@ -576,6 +683,8 @@ bool Scheduler::finish_tile(uint32_t core_id, Tile &tile) {
          _finished_operation_stats.end());
   assert(_active_operation_stats[tile.operation_id].remain_tiles > 0);
   _active_operation_stats[tile.operation_id].remain_tiles--;
+  assert(_core_loads[core_id] > 0);
+  _core_loads[core_id]--;
 
   spdlog::info("Finish tile stage_platform:{}",
                stagePlatformToString(tile.stage_platform));
@@ -592,6 +701,11 @@ bool Scheduler::finish_tile(uint32_t core_id, Tile &tile) {
     spdlog::info("Total compute time {}",
                  *_core_cycle -
                      _active_operation_stats[tile.operation_id].start_cycle);
+    if (Tracer::GetInstance()->enabled())
+      Tracer::GetInstance()->instant(
+          TRACE_PID_SCHEDULER, TRACE_TID_OPERATION,
+          _active_operation_stats[tile.operation_id].name,
+          Tracer::core_us(*_core_cycle));
 
     if (tile.stage_platform == StagePlatform::SA)
       _model_program1->finish_operation(tile.operation_id);
@@ -611,6 +725,119 @@ bool Scheduler::finish_tile(uint32_t core_id, Tile &tile) {
   return result;
 }
 
+void Scheduler::save_state(json &j) {
+  ast(_model_program1 == nullptr && _model_program2 == nullptr);
+
+  std::map<uint32_t, Ptr<InferRequest>> requests;
+  auto ids = [&requests](const auto &queue) {
+    std::vector<uint32_t> ret;
+    for (auto &request : queue) {
+      requests[request->id] = request;
+      ret.push_back(request->id);
+    }
+    return ret;
+  };
+  std::vector<Ptr<InferRequest>> completed;
+  for (auto queue = _completed_request_queue; !queue.empty(); queue.pop())
+    completed.push_back(queue.front());
+
+  j["request_queue"] = ids(_request_queue);
+  j["completed_request_queue"] = ids(completed);
+  j["breq1"] = ids(_breq1);
+  j["breq2"] = ids(_breq2);
+  j["active_request_queues"] = json::array();
+  for (auto &queue : _active_request_queues)
+    j["active_request_queues"].push_back(ids(queue));
+  j["requests"] = json::array();
+  for (auto &[id, request] : requests)
+    j["requests"].push_back(request_to_json(request));
+
+  j["active_request_latency_queues"] = _active_request_latency_queues;
+  j["active_request_accum_latencys"] = _active_request_accum_latencys;
+  j["cycles"] = _cycles;
+  j["stage"] = static_cast<int>(_stage);
+  j["prev_stage"] = static_cast<int>(_prev_stage);
+  j["has_stage_changed"] = _has_stage_changed;
+  j["stage_stats"] = _stage_stats;
+  j["active_reqs"] = _active_reqs;
+  j["next_ch"] = _next_ch;
+  j["placed_requests"] = _placed_requests;
+  j["placed_latency"] = _placed_latency;
+  j["placement_failures"] = _placement_failures;
+  j["next_core1"] = _next_core1;
+  j["next_core2"] = _next_core2;
+  j["dispatched_tiles"] = _dispatched_tiles;
+  j["total_available_tiles"] = _total_available_tiles;
+  j["available_tiles"] = _available_tiles;
+  j["cd_iteration_cycles"] = _cd_iteration_cycles;
+  j["fast_forward_layers"] = _fast_forward_layers;
+  j["pp_iteration_start"] = _pp_iteration_start;
+  j["pp_iterations"] = json::array();
+  for (auto &iteration : _pp_iterations)
+    j["pp_iterations"].push_back(
+        {iteration.device_cycles, iteration.layers,
+         iteration.micro_batch_rows});
+}
+
+void Scheduler::load_state(const json &j) {
+  std::map<uint32_t, Ptr<InferRequest>> requests;
+  for (auto &request : j["requests"]) {
+    auto req = request_from_json(request);
+    requests[req->id] = req;
+  }
+  auto lookup = [&requests](const json &ids) {
+    std::vector<Ptr<InferRequest>> ret;
+    for (uint32_t id : ids) {
+      ast(requests.find(id) != requests.end());
+      ret.push_back(requests[id]);
+    }
+    return ret;
+  };
+
+  auto request_queue = lookup(j["request_queue"]);
+  _request_queue.assign(request_queue.begin(), request_queue.end());
+  _completed_request_queue = {};
+  for (auto &request : lookup(j["completed_request_queue"]))
+    _completed_request_queue.push(request);
+  _breq1 = lookup(j["breq1"]);
+  _breq2 = lookup(j["breq2"]);
+  ast(j["active_request_queues"].size() == _dram_channels);
+  for (int ch = 0; ch < _dram_channels; ch++)
+    _active_request_queues[ch] = lookup(j["active_request_queues"][ch]);
+
+  _active_request_latency_queues =
+      j["active_request_latency_queues"]
+          .get<std::vector<std::vector<uint32_t>>>();
+  _active_request_accum_latencys =
+      j["active_request_accum_latencys"].get<std::vector<uint32_t>>();
+  _cycles = j["cycles"];
+  _stage = static_cast<Stage>(j["stage"].get<int>());
+  _prev_stage = static_cast<Stage>(j["prev_stage"].get<int>());
+  _has_stage_changed = j["has_stage_changed"];
+  _stage_stats =
+      j["stage_stats"].get<std::vector<std::pair<std::string, uint32_t>>>();
+  _active_reqs = j["active_reqs"];
+  _next_ch = j["next_ch"];
+  _placed_requests = j["placed_requests"].get<std::vector<uint64_t>>();
+  _placed_latency = j["placed_latency"].get<std::vector<uint64_t>>();
+  _placement_failures = j["placement_failures"];
+  _next_core1 = j["next_core1"];
+  _next_core2 = j["next_core2"];
+  _dispatched_tiles = j["dispatched_tiles"].get<std::vector<uint64_t>>();
+  _total_available_tiles = j["total_available_tiles"];
+  _available_tiles = j["available_tiles"].get<std::vector<uint32_t>>();
+  _cd_iteration_cycles =
+      j["cd_iteration_cycles"].get<std::vector<uint32_t>>();
+  _fast_forward_layers = j["fast_forward_layers"];
+  _pp_iteration_start = j["pp_iteration_start"];
+  _pp_iterations.clear();
+  for (auto &iteration : j["pp_iterations"])
+    _pp_iterations.push_back(PipelineIteration{
+        .device_cycles = iteration[0],
+        .layers = iteration[1],
+        .micro_batch_rows = iteration[2].get<std::vector<uint32_t>>()});
+}
+
 bool Scheduler::empty1() { return _model_program1 == nullptr; }
 bool Scheduler::empty2() { return _model_program2 == nullptr; }
 
@@ -628,6 +855,7 @@ void Scheduler::cleanup_sub_batch(std::vector<Ptr<InferRequest>> sub_batch) {
     // iteration done -> update request stat in batch
     request->is_initiated = true;
     request->generated++;
+    request->token_cycles.push_back(_cycles);
 
     // clear child operations of Key/Value tensor
     request->K_cache[0]->clear_child_nodes();
@@ -649,10 +877,23 @@ void Scheduler::cleanup_sub_batch(std::vector<Ptr<InferRequest>> sub_batch) {
           itr++;
         }
       }
+      free_kv_cache(request);
     }
   }
 }
 
+void Scheduler::free_kv_cache(Ptr<InferRequest> request) {
+  if (_config.run_mode == RunMode::NPU_PIM) {
+    for (auto &cache : request->K_cache)
+      std::static_pointer_cast<PIMTensor>(cache)->free_blocks();
+    for (auto &cache : request->V_cache)
+      std::static_pointer_cast<PIMTensor>(cache)->free_blocks();
+  }
+  request->K_cache.clear();
+  request->V_cache.clear();
+  release_pim_tiles(request);
+}
+
 void Scheduler::refresh_stage() {
   bool stage_done = _model_program1 == nullptr && _model_program2 == nullptr;
   if (stage_done) {
@@ -673,6 +914,9 @@ void Scheduler::refresh_stage() {
 
     _has_stage_changed = true;
 
+    if (_config.fast_forward && _config.sub_batch_mode && _stage == Stage::E)
+      step_fast_forward();
+
     if (!_config.sub_batch_mode) {
       // >> newton
       if (_stage == Stage::C)
@@ -683,9 +927,79 @@ void Scheduler::refresh_stage() {
     }
     if (_just_one_stage)
       _stage = Stage::Finish; // force to execute just one stage
+
+    if (_stage == Stage::Finish && _config.n_pp > 1)
+      record_pipeline_iteration();
   }
 }
 
+// Called when D is done. Every decoder layer after the first one runs C and D
+// with the same batch, so C/D is simulated again until the C+D cycles of the
+// last two iterations differ less than fast_forward_tolerance. The remaining
+// layers are then skipped and extrapolated by the Simulator. If it does not
+// converge, all (n_layer - 1) iterations are simulated in detail.
+void Scheduler::step_fast_forward() {
+  uint32_t n = _stage_stats.size();
+  // B or previous D is done right before this C starts
+  _cd_iteration_cycles.push_back(_stage_stats[n - 1].second -
+                                 _stage_stats[n - 3].second);
+
+  uint32_t total_layers = std::max(pp_stage_layers(0), (uint32_t)1) - 1;
+  uint32_t simulated = _cd_iteration_cycles.size();
+  if (simulated >= total_layers)
+    return;
+
+  uint32_t warmup = std::max(_config.fast_forward_warmup, (uint32_t)2);
+  if (simulated >= warmup) {
+    double last = _cd_iteration_cycles[simulated - 1];
+    double prev = _cd_iteration_cycles[simulated - 2];
+    double diff = std::abs(last - prev) / prev;
+    if (diff <= _config.fast_forward_tolerance) {
+      _fast_forward_layers = total_layers - simulated;
+      spdlog::info("Fast-forward: C/D converged after {} iterations (diff {:.4f}), "
+                   "extrapolate {} layers",
+                   simulated, diff, _fast_forward_layers);
+      return;
+    }
+    spdlog::info("Fast-forward: C/D not converged (diff {:.4f}), simulate again",
+                 diff);
+  }
+  _stage = Stage::C;
+}
+
+// Layers of a pipeline stage. n_layer is split as evenly as possible and the
+// first stages take the remainder.
+uint32_t Scheduler::pp_stage_layers(uint32_t pp_stage) {
+  uint32_t n_pp = _config.n_pp;
+  return _config.model_n_layer / n_pp +
+         (pp_stage < _config.model_n_layer % n_pp ? 1 : 0);
+}
+
+// Called when the last stage of an iteration is done, before the sub-batches
+// are cleaned up.
+void Scheduler::record_pipeline_iteration() {
+  PipelineIteration iteration{.device_cycles = _cycles - _pp_iteration_start,
+                              .layers = 1,
+                              .micro_batch_rows = {}};
+  if (_config.fast_forward) {
+    // C/D is repeated for every layer of the stage, and the extrapolated
+    // layers are added as the Simulator does
+    iteration.layers = pp_stage_layers(0);
+    uint32_t n = _cd_iteration_cycles.size();
+    if (_fast_forward_layers > 0 && n >= 2)
+      iteration.device_cycles +=
+          (_cd_iteration_cycles[n - 1] + _cd_iteration_cycles[n - 2]) / 2 *
+          _fast_forward_layers;
+  }
+  for (auto *breq : {&_breq1, &_breq2}) {
+    if (breq->empty())
+      continue;
+    iteration.micro_batch_rows.push_back(
+        BatchedRequest(*breq).get_num_rows());
+  }
+  _pp_iterations.push_back(iteration);
+}
+
 void Scheduler::finish_program1() {
   spdlog::info("Model finish at {}", *_core_cycle);
   _model_program1->log();
@@ -903,4 +1217,103 @@ void Scheduler::print_stat() {
 
     prev_cycles = stage_cycles;
   }
+  for (uint32_t core_id = 0; core_id < _n_cores; core_id++)
+    spdlog::info("Core {} : {} tiles dispatched", core_id,
+                 _dispatched_tiles[core_id]);
+  if (_channel_placement != ChannelPlacement::TRACE)
+    print_placement_stat();
+  if (_config.n_pp > 1)
+    print_pipeline_stat();
+}
+
+// Balance of online channel placement: requests and estimated MHA latency
+// placed on each channel. Imbalance is max / mean of the placed latency.
+void Scheduler::print_placement_stat() {
+  std::string fname = Config::global_config.log_dir + "/_placement.tsv";
+  std::ofstream ofile(fname);
+  ast(ofile.is_open());
+  ofile << "channel\trequests\tmha_latency\tavailable_tiles\t\n";
+  uint64_t total_latency = 0;
+  uint64_t max_latency = 0;
+  for (int ch = 0; ch < _dram_channels; ch++) {
+    ofile << ch << "\t" << _placed_requests[ch] << "\t" << _placed_latency[ch]
+          << "\t" << _available_tiles[ch] << "\t\n";
+    total_latency += _placed_latency[ch];
+    max_latency = MAX(max_latency, _placed_latency[ch]);
+  }
+  ofile.close();
+
+  double mean_latency = (double)total_latency / _dram_channels;
+  spdlog::info("Channel placement: imbalance {:.3f} (max / mean MHA latency), "
+               "{} placement failures",
+               mean_latency == 0 ? 1.0 : max_latency / mean_latency,
+               _placement_failures);
+}
+
+// Pipeline replay of the simulated iterations over n_pp devices.
+// Stage k takes t_k = device_cycles / m * layers(k) / iteration.layers per
+// micro-batch (m sub-batches share the device), and a micro-batch of r rows
+// reaches the next stage after latency + r * E * precision / pp_link_bandwidth.
+//  start(k, j) = max(finish(k-1, j) + link(j), finish(k, j-1))
+// The next iteration needs the tokens of the last stage, so iterations do not
+// overlap. Bubble ratio is the idle share of the n_pp devices.
+void Scheduler::print_pipeline_stat() {
+  uint32_t n_pp = _config.n_pp;
+  double bytes_per_cycle = _config.pp_link_bandwidth * 1e3 / _config.core_freq;
+  double link_latency = _config.pp_link_latency * _config.core_freq / 1e3;
+
+  std::string fname = Config::global_config.log_dir + "/_pipeline.tsv";
+  std::ofstream ofile(fname);
+  if (!ofile.is_open()) {
+    assert(0);
+  }
+  ofile << "iteration\tdevice_cycles\tmicro_batches\tpipeline_cycles\t"
+           "bubble_ratio\n";
+
+  double total_cycles = 0;
+  std::vector<double> busy_cycles(n_pp, 0);
+  for (size_t i = 0; i < _pp_iterations.size(); i++) {
+    auto &iteration = _pp_iterations[i];
+    uint32_t m = iteration.micro_batch_rows.size();
+    if (m == 0)
+      continue;
+
+    std::vector<double> finish(m, 0); // finish of micro-batch j at stage k
+    double iteration_busy = 0;
+    for (uint32_t k = 0; k < n_pp; k++) {
+      double t = (double)iteration.device_cycles / m * pp_stage_layers(k) /
+                 iteration.layers;
+      double prev = 0;
+      for (uint32_t j = 0; j < m; j++) {
+        double arrival = finish[j];
+        if (k > 0)
+          arrival += link_latency + (double)iteration.micro_batch_rows[j] *
+                                        _config.model_n_embd *
+                                        _config.precision / bytes_per_cycle;
+        finish[j] = std::max(arrival, prev) + t;
+        prev = finish[j];
+      }
+      busy_cycles[k] += t * m;
+      iteration_busy += t * m;
+    }
+    double pipeline_cycles = finish[m - 1];
+    total_cycles += pipeline_cycles;
+
+    ofile << i << "\t" << iteration.device_cycles << "\t" << m << "\t"
+          << std::llround(pipeline_cycles) << "\t"
+          << 1 - iteration_busy / (n_pp * pipeline_cycles) << "\n";
+  }
+  ofile.close();
+
+  if (total_cycles == 0)
+    return;
+  double total_busy = 0;
+  for (uint32_t k = 0; k < n_pp; k++) {
+    spdlog::info("Pipeline stage {} : {} layers, utilization {:.4f}", k,
+                 pp_stage_layers(k), busy_cycles[k] / total_cycles);
+    total_busy += busy_cycles[k];
+  }
+  spdlog::info("Pipeline ({} stages): {} cycles, bubble ratio {:.4f}", n_pp,
+               std::llround(total_cycles),
+               1 - total_busy / (n_pp * total_cycles));
 }
\ No newline at end of file
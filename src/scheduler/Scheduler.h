@@ -18,7 +18,12 @@ class Scheduler {
     bool empty2();
     bool running();
 
-    void print_stat();
+    virtual void print_stat();
+
+    // fast-forward: number of C/D iterations (decoder layers) that are not simulated
+    // and should be extrapolated from the measured ones
+    uint32_t get_fast_forward_layers() { return _fast_forward_layers; }
+    uint32_t get_simulated_layers() { return _cd_iteration_cycles.size(); }
 
     bool has_stage_changed() { return _has_stage_changed; }
     Stage get_prev_stage() { return _prev_stage; }
@@ -26,10 +31,18 @@ class Scheduler {
 
     /* for communicating inference request & response with Client */
     virtual void cycle();
+    // event-driven clock skipping
+    virtual cycle_type cycles_to_next_event();
+    virtual void skip_cycles(cycle_type cycles) { _cycles += cycles; }
     void add_request(std::shared_ptr<InferRequest> request);
     bool has_completed_request();
     std::shared_ptr<InferRequest> pop_completed_request();
 
+    // checkpoint at a stage boundary (no stage program is running).
+    // requests are stored once and the queues refer to them by id.
+    virtual void save_state(json &j);
+    virtual void load_state(const json &j);
+
    protected:
     // xxx think of better way to check lifetime of operation.
     // maybe operation stat is not the name you want.
@@ -66,6 +79,17 @@ class Scheduler {
 
     uint32_t count_active_operations();
 
+    // multi-core tile dispatch: a core only sees the head tile of a queue when
+    // the dispatch policy picks it
+    TileDispatch _tile_dispatch;
+    uint32_t _n_cores;
+    uint32_t _next_core1;  // round-robin turn of SA / PIM tiles
+    uint32_t _next_core2;
+    std::vector<uint32_t> _core_loads;       // issued and unfinished tiles
+    std::vector<uint64_t> _dispatched_tiles;  // for stat
+    uint32_t dispatch_core(Tile &tile, uint32_t next_core);
+    void dispatch_tile(uint32_t core_id, uint32_t &next_core);
+
     uint32_t _cycles;
     std::deque<std::shared_ptr<InferRequest>> _request_queue;
     std::queue<std::shared_ptr<InferRequest>> _completed_request_queue;
@@ -78,12 +102,25 @@ class Scheduler {
     std::vector<Ptr<InferRequest>> _breq1;
     std::vector<Ptr<InferRequest>> _breq2;
 
-    // channel load balancing
-    bool _ch_load_balancing;
-    uint32_t _next_ch;
+    // online channel placement (channel_placement): a new request is placed on a
+    // channel with enough free PIM tiles for its KV cache when it is admitted, and
+    // the tiles are returned when it completes
+    ChannelPlacement _channel_placement;
+    uint32_t _next_ch;                               // round_robin turn
+    std::map<uint32_t, uint32_t> _planned_channels;  // lookahead: request id -> channel
+    std::vector<uint64_t> _placed_requests;          // for stat
+    std::vector<uint64_t> _placed_latency;
+    uint64_t _placement_failures;
     bool compare_by_seqlen(const Ptr<InferRequest> &a, const Ptr<InferRequest> &b) {
         return a->input_size > b->input_size;
     }
+    uint32_t required_pim_tiles(Ptr<InferRequest> request);
+    int least_latency_channel(uint32_t tiles, const std::vector<uint32_t> &available_tiles,
+                              const std::vector<uint32_t> &accum_latencys);
+    void plan_lookahead();
+    int place_request(Ptr<InferRequest> request);
+    void release_pim_tiles(Ptr<InferRequest> request);
+    void print_placement_stat();
 
     // model dimension
     uint32_t _nh;
@@ -102,8 +139,6 @@ class Scheduler {
     void group_sub_batches();  // sub-batch interleaving algorithm
     int estimate_mha_latency(Ptr<InferRequest> request);
 
-    int allocate_pim_tile(uint32_t seq_len);
-
     bool _partition_alg_simple;
     std::pair<std::vector<int>, std::vector<int>> partition_lists_dp(
         std::vector<uint32_t> latency_list);
@@ -113,10 +148,13 @@ class Scheduler {
     void make_program();
 
     void refresh_stage();
+    void step_fast_forward();
     void finish_program1();
     void finish_program2();
 
     void cleanup_sub_batch(std::vector<Ptr<InferRequest>> sub_batch);
+    // release KV cache blocks of a completed request
+    void free_kv_cache(Ptr<InferRequest> request);
 
     uint32_t _active_reqs;
 
@@ -145,4 +183,22 @@ class Scheduler {
     //
 
     std::vector<std::pair<std::string, uint32_t>> _stage_stats;
+
+    // fast-forward of repeated decoder layers: C/D is repeated until it converges
+    std::vector<uint32_t> _cd_iteration_cycles;  // cycles of each simulated C+D
+    uint32_t _fast_forward_layers;
+
+    // pipeline parallelism: this device is the first of the n_pp pipeline stages
+    // (it has the most layers). Each iteration is replayed over the n_pp stages
+    // with the sub-batches as micro-batches, see print_pipeline_stat()
+    typedef struct {
+        uint32_t device_cycles;                  // A~F of this device
+        uint32_t layers;                         // decoder layers in device_cycles
+        std::vector<uint32_t> micro_batch_rows;  // rows sent to the next stage
+    } PipelineIteration;
+    std::vector<PipelineIteration> _pp_iterations;
+    uint32_t _pp_iteration_start;
+    uint32_t pp_stage_layers(uint32_t pp_stage);
+    void record_pipeline_iteration();
+    void print_pipeline_stat();
 };
@@ -97,6 +97,9 @@ public:
   virtual addr_type get_addr(std::vector<uint32_t> indexes) = 0;
   // 纯虚函数：获取该 Tensor 占用的所有物理地址
   virtual std::vector<addr_type> get_all_addrs() = 0;
+  // 纯虚函数：同 get_all_addrs，但以连续地址段 (base, stride, count) 返回，
+  // 不展开为逐元素列表
+  virtual AddrList get_addr_ranges() = 0;
   // 纯虚函数：用于 KV Cache 等动态 Tensor，增加一个 Token 的容量
   virtual void add_token() = 0;
 
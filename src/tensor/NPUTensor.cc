@@ -148,6 +148,16 @@ std::vector<addr_type> NPUTensor::get_all_addrs() {
   return res;
 }
 
+AddrList NPUTensor::get_addr_ranges() {
+  ast(_inners.size() > 0);
+  AddrList res;
+  for (auto inner : _inners) {
+    for (auto &range : inner->get_addr_ranges().ranges())
+      res.push_range(range.base, range.stride, range.count);
+  }
+  return res;
+}
+
 void NPUTensor::add_token() {
   for (auto inner : _inners) {
     std::static_pointer_cast<NPUTensorKV>(inner)->add_token();
@@ -174,6 +184,18 @@ std::vector<addr_type> NPUTensor::get_row_addrs(uint32_t row_idx) {
   ast(0);
 }
 
+AddrList NPUTensor::get_row_addr_ranges(uint32_t row_idx) {
+  if (_dims.size() == 2) {
+    return std::static_pointer_cast<NPUTensor2D>(_inners[0])
+        ->get_row_addr_ranges(row_idx);
+  } else if (_dims.size() == 3) {
+    auto l = _dims[1];
+    return std::static_pointer_cast<NPUTensor2D>(_inners[row_idx / l])
+        ->get_row_addr_ranges(row_idx % l);
+  }
+  ast(0);
+}
+
 std::vector<Ptr<NPUTensor>>
 NPUTensor::split_by_row(std::vector<uint32_t> row_dims) {
   ast(_inners.size() == 1);
@@ -45,11 +45,13 @@ public:
   //地址计算 (get_addr)：由于数据分散在_inners里，
   // get_addr需要做一个路由（Routing）工作
   virtual std::vector<addr_type> get_all_addrs();
+  virtual AddrList get_addr_ranges();
 
   virtual void set_transposed();
   virtual void unset_transposed();
   virtual void add_token() override; // for KV
   std::vector<addr_type> get_row_addrs(uint32_t row_idx);
+  AddrList get_row_addr_ranges(uint32_t row_idx);
 
   std::vector<Ptr<NPUTensor>>
   split_by_row(std::vector<uint32_t> row_dims); // for 2D
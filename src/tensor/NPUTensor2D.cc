@@ -43,6 +43,13 @@ std::vector<addr_type> NPUTensor2D::get_all_addrs() {
   return ret;
 }
 
+AddrList NPUTensor2D::get_addr_ranges() {
+  AddrList ret;
+  uint32_t count = _dims.size() == 1 ? _dims[0] : _dims[0] * _dims[1];
+  ret.push_range(_base_addr, _precision, count);
+  return ret;
+}
+
 std::vector<addr_type> NPUTensor2D::get_row_addrs(uint32_t row_idx) {
   std::vector<addr_type> ret;
   // _dims: [row, column]
@@ -53,6 +60,14 @@ std::vector<addr_type> NPUTensor2D::get_row_addrs(uint32_t row_idx) {
   return ret;
 }
 
+AddrList NPUTensor2D::get_row_addr_ranges(uint32_t row_idx) {
+  AddrList ret;
+  uint32_t col_size = _dims[1];
+  ret.push_range(_base_addr + row_idx * col_size * _precision, _precision,
+                 col_size);
+  return ret;
+}
+
 std::vector<Ptr<NPUTensor2D>>
 NPUTensor2D::split_by_row(std::vector<uint32_t> row_dims) {
   ast(_dims.size() == 2);
@@ -8,6 +8,8 @@ class NPUTensor2D : public NPUTensorInner {
     NPUTensor2D(std::vector<uint32_t> dims, NPUTensorBufType buf_type);
     virtual addr_type get_addr(std::vector<uint32_t> indexes);
     virtual std::vector<addr_type> get_all_addrs();
+    virtual AddrList get_addr_ranges();
     std::vector<addr_type> get_row_addrs(uint32_t row_idx);
+    AddrList get_row_addr_ranges(uint32_t row_idx);
     std::vector<Ptr<NPUTensor2D>> split_by_row(std::vector<uint32_t> row_dims);
 };
\ No newline at end of file
@@ -13,6 +13,8 @@ class NPUTensorInner {
         : _dims(dims), _buf_type(buf_type), _precision(Config::global_config.precision) {}
     virtual addr_type get_addr(std::vector<uint32_t> indexes) = 0;
     virtual std::vector<addr_type> get_all_addrs() = 0;
+    // same addresses as get_all_addrs, one range per contiguous block
+    virtual AddrList get_addr_ranges() = 0;
 
     addr_type _base_addr;
     std::vector<uint32_t> _dims;
@@ -63,6 +63,21 @@ std::vector<addr_type> NPUTensorKV::get_all_addrs() {
     return ret;
 }
 
+// each entry in _bases holds up to (32, d_k) contiguous elements
+AddrList NPUTensorKV::get_addr_ranges() {
+    AddrList ret;
+    uint32_t d_k = _kv_type == NPUTensorKVType::KEY ? _dims[0] : _dims[1];
+    uint64_t remaining = (uint64_t)_seq_len * d_k;
+    uint32_t entry_count = _kv_cache_entry_size * d_k;
+
+    for (uint32_t idx = 0; remaining > 0; ++idx) {
+        uint32_t count = std::min<uint64_t>(remaining, entry_count);
+        ret.push_range(_bases[idx], _precision, count);
+        remaining -= count;
+    }
+    return ret;
+}
+
 uint32_t NPUTensorKV::get_allocated_seq_len() { return _bases.size() * _kv_cache_entry_size; }
 
 /**
@@ -41,7 +41,24 @@ PIMTensor::PIMTensor(std::string name, uint32_t ch, std::vector<uint32_t> dims,
 
   // 向 KVCacheAlloc 申请指定 Channel 的空闲行
   for (int i = 0; i < num_required_alloc; ++i)
-    _rows.push_back(alloc->allocate(ch));
+    _rows.push_back(allocate_row());
+}
+
+// 使用当前块的下一行，块用完时向 KVCacheAlloc 申请新的块
+uint64_t PIMTensor::allocate_row() {
+  auto alloc = KVCacheAlloc::GetInstance();
+  uint32_t offset = _rows.size() % alloc->_block_rows;
+  if (offset == 0)
+    _blocks.push_back(alloc->allocate(_ch));
+  alloc->use_row(_ch, _blocks.back());
+  return _blocks.back() + offset;
+}
+
+void PIMTensor::free_blocks() {
+  for (auto block : _blocks)
+    KVCacheAlloc::GetInstance()->free(_ch, block);
+  _blocks.clear();
+  _rows.clear();
 }
 
 addr_type PIMTensor::get_addr(std::vector<uint32_t> indexes) { return 0; }
@@ -51,6 +68,8 @@ std::vector<addr_type> PIMTensor::get_all_addrs() {
   return ret;
 }
 
+AddrList PIMTensor::get_addr_ranges() { return AddrList(); }
+
 // 计算当前已分配的物理空间能够容纳的最大 Sequence Length
 uint32_t PIMTensor::get_allocated_seq_len() {
   if (_kv_type == PIMTensorKVType::KEY)
@@ -75,11 +94,41 @@ void PIMTensor::add_token() {
 
   // 否则，需要申请新的 DRAM 行来扩容
   for (int i = 0; i < _num_rows_per_alloc; ++i)
-    _rows.push_back(KVCacheAlloc::GetInstance()->allocate(_ch));
+    _rows.push_back(allocate_row());
 }
 
 uint32_t PIMTensor::get_num_rows() { return _rows.size(); }
 
 uint32_t PIMTensor::get_channel() { return _ch; }
 
-std::vector<uint64_t> PIMTensor::get_rows() { return _rows; }
\ No newline at end of file
+std::vector<uint64_t> PIMTensor::get_rows() { return _rows; }
+
+void PIMTensor::save_state(json &j) {
+  j["name"] = _name;
+  j["ch"] = _ch;
+  j["dims"] = _dims;
+  j["kv_type"] = _kv_type == PIMTensorKVType::KEY ? "key" : "value";
+  j["produced"] = _produced;
+  j["seq_len"] = _seq_len;
+  j["num_rows_per_alloc"] = _num_rows_per_alloc;
+  j["rows"] = _rows;
+  j["blocks"] = _blocks;
+}
+
+void PIMTensor::load_state(const json &j) {
+  auto alloc = KVCacheAlloc::GetInstance();
+  _name = j["name"];
+  _ch = j["ch"];
+  _dims = j["dims"].get<std::vector<uint32_t>>();
+  _kv_type = j["kv_type"] == "key" ? PIMTensorKVType::KEY
+                                   : PIMTensorKVType::VALUE;
+  _precision = Config::global_config.precision;
+  _produced = j["produced"];
+  _seq_len = j["seq_len"];
+  _bank_per_ch = alloc->_bank_per_ch;
+  _num_ele_per_row = alloc->_num_ele_per_row;
+  _E = Config::global_config.model_n_embd;
+  _num_rows_per_alloc = j["num_rows_per_alloc"];
+  _rows = j["rows"].get<std::vector<uint64_t>>();
+  _blocks = j["blocks"].get<std::vector<uint64_t>>();
+}
@@ -24,6 +24,7 @@ public:
 
   // 获取所有分配的地址列表
   virtual std::vector<addr_type> get_all_addrs() override;
+  virtual AddrList get_addr_ranges() override;
 
   // 增加 Token
   // 当推理生成新的 Token 时调用。
@@ -44,6 +45,15 @@ public:
   // 获取所有分配的 DRAM 行索引列表
   std::vector<uint64_t> get_rows();
 
+  // 释放该 Tensor 占用的 KV Cache 块（请求完成时调用）
+  void free_blocks();
+
+  // 检查点：保存/恢复 Tensor 的维度和已分配的行（不重新向 KVCacheAlloc 申请）
+  // child nodes are not saved. they only belong to stage programs that are
+  // already finished.
+  void save_state(json &j);
+  void load_state(const json &j);
+
   PIMTensorKVType _kv_type; // Key 或 Value 类型
   uint32_t _bank_per_ch; // 每个 Channel 的 Bank 数量（影响跨 Bank 并行度）
   uint32_t _E;           // Embedding 维度大小
@@ -59,5 +69,10 @@ public:
   uint32_t _ch;                // DRAM channel (绑定的 Channel ID)
   std::vector<uint64_t> _rows; // store the row index allocated from KVCache.
                                // (存储从 KVCacheAlloc 申请到的行索引)
+  std::vector<uint64_t> _blocks; // KV cache blocks holding _rows
+                                 // (存储 _rows 所在的块起始行索引)
   uint32_t _seq_len;           // 当前实际存储的 Sequence Length
+
+private:
+  uint64_t allocate_row();
 };
\ No newline at end of file